@@ -0,0 +1,200 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include "Affinity.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#endif
+#endif
+
+namespace cola {
+
+    namespace {
+        // the largest number of NUMA nodes a Linux kernel supports
+        [[maybe_unused]] constexpr unsigned long maxNodes = 1024;
+
+        struct CpuTopology {
+            int cpu;
+            int node;
+            int package;
+            int core;
+        };
+
+        int readNumber(const std::filesystem::path& path) {
+            std::ifstream file(path);
+            int value = -1;
+            file >> value;
+            return file ? value : -1;
+        }
+
+        int nodeOf(int cpu) {
+            std::error_code code;
+            const auto dir = std::filesystem::path("/sys/devices/system/cpu") / ("cpu" + std::to_string(cpu));
+            for (const auto& entry : std::filesystem::directory_iterator(dir, code)) {
+                const auto name = entry.path().filename().string();
+                if (name.rfind("node", 0) == 0 and name.size() > 4 and std::isdigit(static_cast<unsigned char>(name[4])))
+                    return std::stoi(name.substr(4));
+            }
+            return -1;
+        }
+
+        CpuTopology topologyOf(int cpu) {
+            const auto dir = std::filesystem::path("/sys/devices/system/cpu") / ("cpu" + std::to_string(cpu)) / "topology";
+            return {cpu, nodeOf(cpu), readNumber(dir / "physical_package_id"), readNumber(dir / "core_id")};
+        }
+
+        std::vector<int> allowedCpus() {
+            std::vector<int> cpus;
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0)
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                    if (CPU_ISSET(cpu, &set))
+                        cpus.push_back(cpu);
+#endif
+            return cpus;
+        }
+
+        // neighbouring CPUs (hyperthreads of a core, cores of a package and a node) are adjacent
+        std::vector<CpuTopology> compactOrder(std::vector<CpuTopology> cpus) {
+            std::sort(cpus.begin(), cpus.end(), [](const CpuTopology& a, const CpuTopology& b) {
+                return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+            });
+            return cpus;
+        }
+
+        // nodes alternate, and inside a node all physical cores are used before their hyperthreads
+        std::vector<CpuTopology> scatterOrder(const std::vector<CpuTopology>& cpus) {
+            std::map<int, std::vector<std::pair<int, CpuTopology>>> nodes;
+            std::map<std::tuple<int, int, int>, int> siblings;
+            for (const auto& cpu : compactOrder(cpus)) {
+                const int rank = siblings[{cpu.node, cpu.package, cpu.core}]++;
+                nodes[cpu.node].emplace_back(rank, cpu);
+            }
+            for (auto& node : nodes) {
+                std::stable_sort(node.second.begin(), node.second.end(),
+                                 [](const auto& a, const auto& b) { return a.first < b.first; });
+            }
+
+            std::vector<CpuTopology> order;
+            for (size_t i = 0; order.size() < cpus.size(); i++)
+                for (const auto& node : nodes)
+                    if (i < node.second.size())
+                        order.push_back(node.second[i].second);
+            return order;
+        }
+    }
+
+    std::vector<CpuPlacement> planPlacement(const RunOptions& options, size_t nWorkers) {
+        std::vector<CpuTopology> order;
+        if (not options.cpus.empty()) {
+            for (int cpu : options.cpus)
+                order.push_back(topologyOf(cpu));
+        } else if (options.affinity != AffinityPolicy::none) {
+            std::vector<CpuTopology> cpus;
+            for (int cpu : allowedCpus())
+                cpus.push_back(topologyOf(cpu));
+            order = options.affinity == AffinityPolicy::compact ? compactOrder(cpus) : scatterOrder(cpus);
+        }
+        std::vector<CpuPlacement> placement(nWorkers);
+        if (not order.empty())
+            for (size_t i = 0; i < nWorkers; i++)
+                placement[i] = {order[i % order.size()].cpu, order[i % order.size()].node};
+        return placement;
+    }
+
+    void pinCurrentThread(const CpuPlacement& placement) {
+        if (placement.cpu < 0)
+            return;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (placement.cpu < CPU_SETSIZE)
+            CPU_SET(placement.cpu, &set);
+        if (placement.cpu >= CPU_SETSIZE or pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            throw std::runtime_error("ERROR in ColaRunManager: Couldn't pin a worker to CPU " + std::to_string(placement.cpu) + ".");
+#if defined(MPOL_LOCAL) && defined(SYS_set_mempolicy)
+        // first touch already favours the local node, this also overrides an inherited interleaving policy
+        syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0);
+#endif
+#else
+        throw std::runtime_error("ERROR in ColaRunManager: CPU affinity is not supported on this platform.");
+#endif
+    }
+
+    void logPlacement(const std::vector<std::string>& names, const std::vector<CpuPlacement>& placement) {
+        if (std::none_of(placement.begin(), placement.end(), [](const CpuPlacement& item) { return item.cpu >= 0; }))
+            return;
+        std::cout << "Worker placement:\n";
+        for (size_t i = 0; i < names.size() and i < placement.size(); i++) {
+            std::cout << names[i] << ": CPU " << placement[i].cpu;
+            if (placement[i].node >= 0)
+                std::cout << " (NUMA node " << placement[i].node << ")";
+            std::cout << '\n';
+        }
+    }
+
+    AffinityGuard::AffinityGuard(const CpuPlacement& placement) {
+        if (placement.cpu < 0)
+            return;
+        saved = allowedCpus();
+#if defined(SYS_get_mempolicy)
+        savedNodes.assign(maxNodes / (8 * sizeof(unsigned long)), 0);
+        int mode;
+        if (syscall(SYS_get_mempolicy, &mode, savedNodes.data(), maxNodes, nullptr, 0) == 0)
+            savedPolicy = mode;
+#endif
+        pinCurrentThread(placement);
+    }
+
+    AffinityGuard::~AffinityGuard() {
+#if defined(__linux__)
+        if (saved.empty())
+            return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : saved)
+            CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#if defined(MPOL_DEFAULT) && defined(SYS_set_mempolicy)
+        // the policy found by the constructor, e.g. interleaving set by numactl
+        if (savedPolicy < 0 or savedPolicy == MPOL_DEFAULT or
+            syscall(SYS_set_mempolicy, savedPolicy, savedNodes.data(), maxNodes) != 0)
+            syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+#endif
+#endif
+    }
+} // namespace cola
@@ -0,0 +1,79 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef COLA_AFFINITY_HH
+#define COLA_AFFINITY_HH
+
+#include <string>
+#include <vector>
+
+#include "COLA.hh"
+
+namespace cola {
+
+    /** A logical CPU a worker is pinned to.
+     */
+    struct CpuPlacement {
+        int cpu = -1;   /**< Logical CPU number, negative if the worker is not pinned. */
+        int node = -1; /**< NUMA node of the CPU, negative if unknown. */
+    };
+
+    /** Choose CPUs for the workers according to the run options.
+     *  Only CPUs the process is allowed to run on are considered. If there are more workers than CPUs, the CPUs are
+     *  reused in the same order.
+     *  @param options Run options with the affinity policy or an explicit CPU list.
+     *  @param nWorkers Number of workers.
+     *  @return Placements of every worker, all of them unpinned if workers are not to be pinned.
+     */
+    std::vector<CpuPlacement> planPlacement(const RunOptions& options, size_t nWorkers);
+
+    /** Pin the calling thread to the CPU and make it allocate memory on the local NUMA node.
+     *  @param placement CPU to pin to. Nothing is done for an unpinned placement.
+     */
+    void pinCurrentThread(const CpuPlacement& placement);
+
+    /** Print the placement of the workers.
+     *  @param names Names of the workers.
+     *  @param placement Placements of the workers as returned by planPlacement. Nothing is printed if no worker is pinned.
+     */
+    void logPlacement(const std::vector<std::string>& names, const std::vector<CpuPlacement>& placement);
+
+    /** Pins the calling thread for its lifetime and restores the previous CPU affinity and memory policy on destruction.
+     *  Used when the thread calling ColaRunManager::run takes part in the run as one of the workers.
+     */
+    class AffinityGuard {
+    public:
+        /** Constructor.
+         * @param placement CPU to pin to. Nothing is done for an unpinned placement.
+         */
+        explicit AffinityGuard(const CpuPlacement& placement);
+        AffinityGuard(const AffinityGuard&) = delete;
+        AffinityGuard& operator=(const AffinityGuard&) = delete;
+        ~AffinityGuard();
+
+    private:
+        std::vector<int> saved;
+        int savedPolicy = -1;                   // -1 if the memory policy couldn't be read
+        std::vector<unsigned long> savedNodes;  // node mask of the memory policy
+    };
+} // namespace cola
+
+#endif // COLA_AFFINITY_HH
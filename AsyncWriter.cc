@@ -0,0 +1,102 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "AsyncWriter.hh"
+#include "EventPool.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cola {
+
+    AsyncWriter::AsyncWriter(std::unique_ptr<VWriter>&& writer, size_t bufferSize)
+            : writer(std::move(writer)), bufferSize(std::max<size_t>(bufferSize, 1)) {
+        if (not this->writer)
+            throw std::invalid_argument("ERROR in AsyncWriter: No writer to wrap.");
+        front.reserve(this->bufferSize);
+        thread = std::thread(&AsyncWriter::loop, this);
+    }
+
+    AsyncWriter::~AsyncWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        filled.notify_one();
+        thread.join();
+    }
+
+    void AsyncWriter::operator()(std::unique_ptr<EventData>&& data) {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return front.size() < bufferSize or error; });
+        if (error)
+            std::rethrow_exception(error);
+        front.push_back(std::move(data));
+        if (front.size() == 1)
+            filled.notify_one();
+    }
+
+    void AsyncWriter::flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return (front.empty() and not writing) or error; });
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void AsyncWriter::setEventPool(std::shared_ptr<EventPool> pool) {
+        std::lock_guard<std::mutex> lock(mutex);
+        eventPool = std::move(pool);
+    }
+
+    void AsyncWriter::loop() {
+        EventBatch back;
+        back.reserve(bufferSize);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            filled.wait(lock, [this] { return not front.empty() or stopping; });
+            if (front.empty())
+                return;
+            std::swap(front, back);
+            writing = true;
+            drained.notify_all();
+
+            lock.unlock();
+            std::exception_ptr failure;
+            try {
+                // the whole back buffer at once, so that writers with a batch form save it in one go
+                writer->writeBatch(back);
+                if (eventPool)
+                    for (auto& event : back)
+                        eventPool->release(std::move(event));
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            back.clear();
+            lock.lock();
+
+            writing = false;
+            if (failure and not error)
+                error = failure;
+            if (error)
+                front.clear();
+            drained.notify_all();
+        }
+    }
+} // namespace cola
@@ -0,0 +1,90 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_ASYNCWRITER_HH
+#define COLA_ASYNCWRITER_HH
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "COLA.hh"
+
+namespace cola {
+
+    /** A writer adapter that saves events on a dedicated thread.
+     *  Events passed to AsyncWriter::operator() are collected in a front buffer, while the writer thread saves the
+     *  previous batch from a back buffer with the wrapped writer; the buffers are swapped once the back one is written
+     *  out. Thus a stall in the wrapped writer (e.g. on the filesystem) only blocks the event loop when the front buffer
+     *  is full. The wrapped writer is only called from the writer thread and needs no changes.
+     *  An exception thrown by the wrapped writer is rethrown by the next call of AsyncWriter::operator() or
+     *  AsyncWriter::flush, the events received after it are dropped.
+     *  A <writer> element of the configuration XML-file with the "async" attribute set to "true" is wrapped into this
+     *  class by MetaProcessor::parse. See MetaProcessor::parse for details.
+     */
+    class AsyncWriter final : public VWriter {
+    public:
+        /** Constructor. Starts the writer thread.
+         * @param writer Writer to be called on the writer thread.
+         * @param bufferSize Maximal number of events in the front buffer before AsyncWriter::operator() blocks.
+         */
+        explicit AsyncWriter(std::unique_ptr<VWriter>&& writer, size_t bufferSize = 64);
+        /** Destructor. Writes out all the buffered events and stops the writer thread. Errors are not reported here,
+         *  call AsyncWriter::flush to get them.
+         */
+        ~AsyncWriter() override;
+
+        /** Queue an event to be saved by the wrapped writer.
+         *  @param data A pointer to the EventData to be saved.
+         */
+        void operator()(std::unique_ptr<EventData>&& data) override;
+
+        /** Block until all the queued events are saved by the wrapped writer.
+         *  Rethrows the exception of the wrapped writer, if any.
+         */
+        void flush();
+
+        /** Set the pool receiving the events the wrapped writer has left in place. Called by ColaRunManager.
+         *  @param pool Pool of spare events, null to delete the events.
+         */
+        void setEventPool(std::shared_ptr<EventPool> pool);
+
+    private:
+        void loop();
+
+        std::unique_ptr<VWriter> writer;
+        const size_t bufferSize;
+        std::shared_ptr<EventPool> eventPool;
+
+        std::mutex mutex;
+        std::condition_variable filled;     // the front buffer has events or the writer is stopping
+        std::condition_variable drained;    // the buffers were swapped or the back buffer was written out
+        EventBatch front;
+        bool writing = false;
+        bool stopping = false;
+        std::exception_ptr error;
+
+        std::thread thread;
+    };
+} // namespace cola
+
+#endif // COLA_ASYNCWRITER_HH
@@ -19,9 +19,28 @@
 */
 
 #include "COLA.hh"
+#include "Affinity.hh"
+#include "AsyncWriter.hh"
+#include "EventPool.hh"
+#include "EventQueue.hh"
+#include "SharedMemory.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 #include <tinyxml2.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace cola {
 
     // converters
@@ -58,8 +77,34 @@ namespace cola {
         return 1000000000 + data.first * 10 + data.second * 10000;
     }
 
-    AZ Particle::getAZ() const {
-        return pdgToAZ(pdgCode);
+    std::unique_ptr<EventData> makeEvent(size_t arenaSize) {
+        auto event = std::make_unique<EventData>();
+        if (arenaSize > 0) {
+            ArenaAllocator<Particle> allocator(std::make_shared<std::pmr::monotonic_buffer_resource>(arenaSize));
+            event->particles = EventParticles(allocator);
+            event->iniState.iniStateParticles = EventParticles(allocator);
+        }
+        return event;
+    }
+
+    bool finiteKinematics(const EventData& event) {
+        return finiteKinematics(event.particles) and finiteKinematics(event.iniState.iniStateParticles.get());
+    }
+
+    // filters
+
+    std::unique_ptr<EventData> VGenerator::newEvent() const {
+        return eventPool ? eventPool->acquire() : makeEvent();
+    }
+
+    void VConverter::processBatch(EventBatch& batch) {
+        for (auto& event : batch)
+            event = (*this)(std::move(event));
+    }
+
+    void VWriter::writeBatch(EventBatch& batch) {
+        for (auto& event : batch)
+            (*this)(std::move(event));
     }
 
     // operators
@@ -111,7 +156,47 @@ namespace cola {
         return params;
     }
 
-    FilterEnsemble MetaProcessor::parse(const std::string &fName) const {
+    unsigned int _extract_replicas(std::map<std::string, std::string>& params) {
+        auto it = params.find("replicas");
+        if (it == params.end())
+            return 1;
+        unsigned long replicas = 0;
+        try {
+            replicas = std::stoul(it->second);
+        } catch (const std::logic_error&) {
+        }
+        if (replicas == 0)
+            throw std::runtime_error("ERROR in MetaProcessor: Number of replicas must be a positive integer, got `" + it->second + "`.");
+        params.erase(it);
+        return static_cast<unsigned int>(replicas);
+    }
+
+    // Returns the size of the front buffer of the asynchronous writer, zero if the writer is synchronous.
+    size_t _extract_async(std::map<std::string, std::string>& params) {
+        auto it = params.find("async");
+        if (it == params.end())
+            return 0;
+        if (it->second != "true" and it->second != "false")
+            throw std::runtime_error("ERROR in MetaProcessor: Attribute `async` must be `true` or `false`, got `" + it->second + "`.");
+        const bool async = it->second == "true";
+        params.erase(it);
+
+        unsigned long bufferSize = 64;
+        it = params.find("asyncBuffer");
+        if (it != params.end()) {
+            bufferSize = 0;
+            try {
+                bufferSize = std::stoul(it->second);
+            } catch (const std::logic_error&) {
+            }
+            if (bufferSize == 0)
+                throw std::runtime_error("ERROR in MetaProcessor: Size of the asynchronous buffer must be a positive integer, got `" + it->second + "`.");
+            params.erase(it);
+        }
+        return async ? bufferSize : 0;
+    }
+
+    FilterEnsemble MetaProcessor::parse(const std::string &fName, bool primary, bool replicateConverters) const {
         using namespace tinyxml2;
         std::cout << "Parsing XML file:" << '\n';
         XMLDocument file;
@@ -128,13 +213,23 @@ namespace cola {
             currentElement = currentElement->NextSiblingElement();
             while (currentElement->Name() != std::string("writer")) {
                 params = _get_name_and_params(currentElement, name);
-                ensemble.converters.push_back(std::unique_ptr<VConverter>(dynamic_cast<VConverter*>(converterMap.at(name)->create(params))));
+                const unsigned int replicas = _extract_replicas(params);
+                const auto& factory = converterMap.at(name);
+                ensemble.converters.push_back(std::unique_ptr<VConverter>(dynamic_cast<VConverter*>(factory->create(params))));
+                ensemble.converterReplicas.emplace_back();
+                for (unsigned int i = 1; primary and replicateConverters and i < replicas; i++)
+                    ensemble.converterReplicas.back().push_back(std::unique_ptr<VConverter>(dynamic_cast<VConverter*>(factory->create(params))));
                 params.clear();
                 currentElement = currentElement->NextSiblingElement();
             }
 
-            params = _get_name_and_params(currentElement, name);
-            ensemble.writer = std::unique_ptr<VWriter>(dynamic_cast<VWriter*>(writerMap.at(name)->create(params)));
+            if (primary) {
+                params = _get_name_and_params(currentElement, name);
+                const size_t asyncBuffer = _extract_async(params);
+                ensemble.writer = std::unique_ptr<VWriter>(dynamic_cast<VWriter*>(writerMap.at(name)->create(params)));
+                if (asyncBuffer > 0)
+                    ensemble.writer = std::make_unique<AsyncWriter>(std::move(ensemble.writer), asyncBuffer);
+            }
             return ensemble;
         } else {
             throw std::runtime_error("ERROR in MetaProcessor: Couldn't open file `" + fName + "`.\nError code (tinyxml2): " +
@@ -142,15 +237,759 @@ namespace cola {
         }
     }
 
+    // Scheduling
+
+    namespace {
+        /* Work-stealing distribution of event indices between workers of an unordered run.
+         * Every worker starts with an equal contiguous range and takes events from its front one by one. A worker that
+         * has run out of events steals the back half of another worker's range, so that the run ends at most one
+         * event after the last event was started, however unevenly the cost is distributed.
+         */
+        class StealingScheduler {
+        public:
+            StealingScheduler(int n, int nWorkers) : ranges(nWorkers), remaining(std::max(n, 0)) {
+                int begin = 0;
+                for (int i = 0; i < nWorkers; i++) {
+                    ranges[i].begin = begin;
+                    begin += remaining / nWorkers + (i < remaining % nWorkers);
+                    ranges[i].end = begin;
+                }
+            }
+
+            // Get the next event index for the worker. Returns false if there are no events left.
+            bool next(int worker, int& index) {
+                auto& own = ranges[worker];
+                {
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (own.begin < own.end) {
+                        index = own.begin++;
+                        --remaining;
+                        return true;
+                    }
+                }
+                const int nWorkers = static_cast<int>(ranges.size());
+                while (remaining > 0) {
+                    for (int offset = 1; offset < nWorkers; offset++) {
+                        auto& victim = ranges[(worker + offset) % nWorkers];
+                        std::scoped_lock lock(own.mutex, victim.mutex);
+                        const int left = victim.end - victim.begin;
+                        if (left > 0) {
+                            own.end = victim.end;
+                            victim.end -= (left + 1) / 2;
+                            own.begin = victim.end;
+                            index = own.begin++;
+                            --remaining;
+                            return true;
+                        }
+                    }
+                    // some events are in transit between two other workers
+                    std::this_thread::yield();
+                }
+                return false;
+            }
+
+        private:
+            struct alignas(64) Range {
+                std::mutex mutex;
+                int begin = 0;
+                int end = 0;
+            };
+
+            std::vector<Range> ranges;
+            std::atomic<int> remaining;
+        };
+
+        // An event tagged with its generation order and the size it holds in the in-flight budget.
+        struct TaggedEvent {
+            size_t seq = 0;
+            size_t bytes = 0;
+            std::unique_ptr<EventData> data;
+            EventPool* pool = nullptr;  // pool of the producing worker, null for the shared one
+        };
+
+        std::unique_ptr<EventData> generate(VGenerator& generator, std::int64_t index) {
+            generator.setEventIndex(index);
+            return generator();
+        }
+
+        size_t eventBytes(const EventData& data) {
+            // shared initial state particles are not held by the event alone
+            const auto& iniStateParticles = data.iniState.iniStateParticles;
+            return sizeof(EventData) + (data.particles.capacity() + (iniStateParticles.shared() ? 0 : iniStateParticles.capacity())) * sizeof(Particle);
+        }
+
+        /* Passes tagged events through a converter in one batch.
+         * Events rejected earlier in the chain are left out, so that converters only see valid events. Events rejected
+         * by the converter stay in place with a null pointer, which keeps their tags for the writer.
+         */
+        class ConverterBatch {
+        public:
+            void apply(VConverter& converter, std::vector<TaggedEvent>& events) {
+                for (size_t i = 0; i < events.size(); i++) {
+                    if (events[i].data) {
+                        batch.push_back(std::move(events[i].data));
+                        slots.push_back(i);
+                    }
+                }
+                if (not batch.empty())
+                    converter.processBatch(batch);
+                for (size_t i = 0; i < slots.size(); i++)
+                    events[slots[i]].data = std::move(batch[i]);
+                batch.clear();
+                slots.clear();
+            }
+
+        private:
+            EventBatch batch;
+            std::vector<size_t> slots;
+        };
+
+        // The pool of events drawn by VGenerator::newEvent, null if events are neither recycled nor specially created.
+        std::shared_ptr<EventPool> makeEventPool(const RunOptions& options) {
+            if (options.eventFactory)
+                return std::make_shared<EventPool>(options.eventPoolSize, options.eventFactory);
+            if (options.eventPoolSize > 0 or options.eventArenaSize > 0)
+                return std::make_shared<EventPool>(options.eventPoolSize, options.eventArenaSize);
+            return nullptr;
+        }
+
+        void dropRejected(EventBatch& batch) {
+            batch.erase(std::remove(batch.begin(), batch.end(), nullptr), batch.end());
+        }
+
+        /* Counts the events taken by the writer in a run that may be limited by their number.
+         * Only the thread calling the writer counts, while producers check whether the target has been reached.
+         */
+        class AcceptedEvents {
+        public:
+            explicit AcceptedEvents(int target) : target(target), reached(target == 0) {}
+
+            // Whether the writer may take one more event.
+            bool admit() {
+                if (target < 0)
+                    return true;
+                if (count == target)
+                    return false;
+                if (++count == target)
+                    reached = true;
+                return true;
+            }
+
+            // Drop the rejected events of the batch and the ones beyond the target.
+            void admit(EventBatch& batch) {
+                dropRejected(batch);
+                size_t kept = 0;
+                while (kept < batch.size() and admit())
+                    kept++;
+                batch.resize(kept);
+            }
+
+            bool done() const { return reached; }
+
+        private:
+            const int target;
+            int count = 0;
+            std::atomic<bool> reached;
+        };
+
+        /* A link between two pipeline stages.
+         * A single-producer single-consumer queue is used when both stages have one instance, a multi-producer
+         * multi-consumer one otherwise. Instances of a replicated stage take events from the shared queue as soon as
+         * they are free, which balances the load between them.
+         */
+        template <typename Type>
+        class StageLink {
+        public:
+            StageLink(size_t capacity, unsigned int producers, unsigned int consumers) {
+                if (producers == 1 and consumers == 1)
+                    spsc = std::make_unique<SPSCQueue<Type>>(capacity);
+                else
+                    mpmc = std::make_unique<MPMCQueue<Type>>(capacity, producers);
+            }
+
+            bool push(Type&& item) { return spsc ? spsc->push(std::move(item)) : mpmc->push(std::move(item)); }
+            bool pop(Type& item) { return spsc ? spsc->pop(item) : mpmc->pop(item); }
+            void close() { spsc ? spsc->close() : mpmc->close(); }
+            void abort() { spsc ? spsc->abort() : mpmc->abort(); }
+
+        private:
+            std::unique_ptr<SPSCQueue<Type>> spsc;
+            std::unique_ptr<MPMCQueue<Type>> mpmc;
+        };
+    }
+
     // Run manager
 
+    ColaRunManager::ColaRunManager(FilterEnsemble&& ensemble, const RunOptions& options)
+            : filterEnsemble(std::move(ensemble)), runOptions(options) {
+        if ((runOptions.mode == RunMode::replicated and runOptions.workers != 1) or runOptions.mode == RunMode::forked)
+            throw std::invalid_argument("ERROR in ColaRunManager: Several workers need a MetaProcessor to replicate the model.");
+        attachEventPool();
+    }
+
+    ColaRunManager::ColaRunManager(const MetaProcessor& processor, const std::string& fName, const RunOptions& options)
+            : filterEnsemble(processor.parse(fName, true, options.mode == RunMode::pipelined)), runOptions(options),
+              metaProcessor(&processor), configName(fName) {
+        if (runOptions.workers == 0)
+            throw std::invalid_argument("ERROR in ColaRunManager: Number of workers must be positive.");
+        if (runOptions.mode == RunMode::replicated)
+            for (unsigned int i = 1; i < runOptions.workers; i++)
+                replicas.push_back(processor.parse(fName, false));
+        attachEventPool();
+    }
+
+    void ColaRunManager::attachEventPool() {
+        eventPool = makeEventPool(runOptions);
+        if (not eventPool)
+            return;
+        filterEnsemble.generator->setEventPool(eventPool);
+        for (auto& replica : replicas)
+            replica.generator->setEventPool(eventPool);
+        if (auto asyncWriter = dynamic_cast<AsyncWriter*>(filterEnsemble.writer.get()))
+            asyncWriter->setEventPool(eventPool);
+    }
+
+    void ColaRunManager::writeEvent(std::unique_ptr<EventData>&& event, EventPool* pool) const {
+        std::move(event) | filterEnsemble.writer;
+        // the writer may have taken the ownership
+        if (not pool)
+            pool = eventPool.get();
+        if (pool)
+            pool->release(std::move(event));
+    }
+
+    void ColaRunManager::writeBatch(EventBatch& batch, EventPool* pool) const {
+        filterEnsemble.writer->writeBatch(batch);
+        if (not pool)
+            pool = eventPool.get();
+        if (pool)
+            for (auto& event : batch)
+                pool->release(std::move(event));
+        batch.clear();
+    }
+
     void ColaRunManager::run(int n) const {
-        for(int k = 0; k < n; k++) {
-            auto event = (*(filterEnsemble.generator))();
-            for (const auto& converter : filterEnsemble.converters)
-                event = std::move(event) | converter;
-            std::move(event) | filterEnsemble.writer;
+        dispatch(n, -1);
+    }
+
+    void ColaRunManager::runUntilAccepted(int nAccepted, int maxEvents) const {
+        if (nAccepted < 0)
+            throw std::invalid_argument("ERROR in ColaRunManager: Number of accepted events must be non-negative.");
+        dispatch(maxEvents, nAccepted);
+    }
+
+    void ColaRunManager::dispatch(int n, int nAccepted) const {
+        if (runOptions.mode == RunMode::pipelined)
+            runPipelined(n, nAccepted);
+        else if (runOptions.mode == RunMode::forked)
+            runForked(n, nAccepted);
+        else if (not replicas.empty())
+            runParallel(n, nAccepted);
+        else
+            runSequential(n, nAccepted);
+
+        // the run is over only when the events are saved
+        if (auto asyncWriter = dynamic_cast<AsyncWriter*>(filterEnsemble.writer.get()))
+            asyncWriter->flush();
+    }
+
+    void ColaRunManager::runSequential(int n, int nAccepted) const {
+        const auto placement = planPlacement(runOptions, 1);
+        logPlacement({"worker 0"}, placement);
+        AffinityGuard guard(placement[0]);
+        const size_t batchSize = std::max<size_t>(runOptions.batchSize, 1);
+        AcceptedEvents accepted(nAccepted);
+        EventBatch batch;
+        for (int k = 0; k < n and not accepted.done();) {
+            for (; k < n and batch.size() < batchSize; k++)
+                batch.push_back(generate(*filterEnsemble.generator, k));
+            for (const auto& converter : filterEnsemble.converters) {
+                converter->processBatch(batch);
+                dropRejected(batch);
+            }
+            accepted.admit(batch);
+            writeBatch(batch);
+        }
+    }
+
+    void ColaRunManager::runParallel(int n, int nAccepted) const {
+        const int nWorkers = static_cast<int>(replicas.size()) + 1;
+        std::mutex writerMutex;
+        ReorderBuffer<TaggedEvent> reorderBuffer(runOptions.reorderWindow);
+        InFlightBudget budget(runOptions.maxEventsInFlight, runOptions.maxBytesInFlight);
+        AcceptedEvents accepted(nAccepted);
+        std::atomic<bool> stopped{false};
+        std::vector<std::exception_ptr> errors(nWorkers);
+        // called on an error or once enough events are written, wakes up all the waiting workers
+        auto stop = [&] {
+            stopped = true;
+            reorderBuffer.abort();
+            budget.abort();
+        };
+
+        auto write = [this, &budget, &accepted](TaggedEvent&& event) {
+            if (event.data and accepted.admit())
+                writeEvent(std::move(event.data), event.pool);
+            if (budget.limited())
+                budget.release(event.bytes);
+        };
+
+        // workers take events from the scheduler, the writer is called by one worker at a time. In an ordered run the
+        // workers instead take batches of consecutive events from a shared counter: with a contiguous range of its own a
+        // worker would be ahead of the reorder window and wait for the others most of the time
+        StealingScheduler scheduler(runOptions.ordered ? 0 : n, nWorkers);
+        std::atomic<std::int64_t> nextIndex{0};
+        const auto placement = planPlacement(runOptions, nWorkers);
+        std::vector<std::string> names;
+        for (int i = 0; i < nWorkers; i++)
+            names.push_back("worker " + std::to_string(i));
+        logPlacement(names, placement);
+
+        // pinned workers allocate their events on their own NUMA nodes, so the events are recycled to the same worker
+        std::vector<std::shared_ptr<EventPool>> pools(nWorkers);
+        const bool pinned = std::any_of(placement.begin(), placement.end(), [](const CpuPlacement& item) { return item.cpu >= 0; });
+        if (eventPool and pinned)
+            for (auto& pool : pools)
+                pool = makeEventPool(runOptions);
+
+        // in an ordered run a batch holds consecutive events, which must fit into the reorder window together
+        const size_t batchSize = std::max<size_t>(runOptions.ordered ? std::min(runOptions.batchSize, runOptions.reorderWindow) : runOptions.batchSize, 1);
+
+        auto work = [&](const FilterEnsemble& ensemble, int worker, std::exception_ptr& error) {
+            try {
+                AffinityGuard guard(placement[worker]);
+                EventPool* pool = pools[worker].get();
+                if (pool)
+                    ensemble.generator->setEventPool(pools[worker]);
+                std::vector<TaggedEvent> events;
+                ConverterBatch converterBatch;
+                EventBatch batch;
+                auto process = [&] {
+                    for (const auto& converter : ensemble.converters)
+                        converterBatch.apply(*converter, events);
+
+                    if (runOptions.ordered) {
+                        for (auto& event : events)
+                            reorderBuffer.push(event.seq, std::move(event), write);
+                    } else {
+                        for (auto& event : events)
+                            batch.push_back(std::move(event.data));
+                        std::lock_guard<std::mutex> lock(writerMutex);
+                        accepted.admit(batch);
+                        writeBatch(batch, pool);
+                        if (budget.limited())
+                            for (const auto& event : events)
+                                budget.release(event.bytes);
+                    }
+                    events.clear();
+                    // the writer is called under a lock, which stop() must not be called under
+                    if (accepted.done())
+                        stop();
+                };
+
+                std::vector<int> indices;
+                int index;
+                bool more = true;
+                while (more and not stopped) {
+                    indices.clear();
+                    if (runOptions.ordered) {
+                        const std::int64_t first = nextIndex.fetch_add(batchSize);
+                        for (std::int64_t i = first; i < n and i < first + static_cast<std::int64_t>(batchSize); i++)
+                            indices.push_back(static_cast<int>(i));
+                        more = first + static_cast<std::int64_t>(batchSize) < n;
+                    } else {
+                        while (indices.size() < batchSize) {
+                            if (not scheduler.next(worker, index)) {
+                                more = false;
+                                break;
+                            }
+                            indices.push_back(index);
+                        }
+                    }
+
+                    for (int i : indices) {
+                        if (runOptions.ordered and not reorderBuffer.admit(i))
+                            return;
+                        TaggedEvent event{static_cast<size_t>(i), 0, generate(*ensemble.generator, i), pool};
+                        if (budget.limited()) {
+                            event.bytes = eventBytes(*event.data);
+                            if (not budget.tryAcquire(event.bytes)) {
+                                // don't wait for the budget while holding events, the event awaited by the writer can't wait at all
+                                process();
+                                auto awaited = [&] { return runOptions.ordered and reorderBuffer.expected() == event.seq; };
+                                if (not budget.acquire(event.bytes, awaited))
+                                    return;
+                            }
+                        }
+                        events.push_back(std::move(event));
+                    }
+                    process();
+                }
+            } catch (...) {
+                error = std::current_exception();
+                stop();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < nWorkers; i++)
+            threads.emplace_back(work, std::cref(replicas[i - 1]), i, std::ref(errors[i]));
+        // the calling thread is the first worker
+        work(filterEnsemble, 0, errors[0]);
+        for (auto& thread : threads)
+            thread.join();
+        if (eventPool and pinned) {
+            filterEnsemble.generator->setEventPool(eventPool);
+            for (const auto& replica : replicas)
+                replica.generator->setEventPool(eventPool);
+        }
+
+        for (const auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    void ColaRunManager::runPipelined(int n, int nAccepted) const {
+        // events travel in batches, in an ordered run a batch must fit into the reorder window
+        using EventLink = StageLink<std::vector<TaggedEvent>>;
+        const size_t batchSize = std::max<size_t>(runOptions.ordered ? std::min(runOptions.batchSize, runOptions.reorderWindow) : runOptions.batchSize, 1);
+        const size_t capacity = std::max<size_t>(runOptions.queueCapacity / batchSize, 1);
+        const size_t nStages = filterEnsemble.converters.size();
+
+        // all instances of every converter stage, the first one is the converter itself
+        std::vector<std::vector<VConverter*>> stages(nStages);
+        for (size_t i = 0; i < nStages; i++) {
+            stages[i].push_back(filterEnsemble.converters[i].get());
+            if (i < filterEnsemble.converterReplicas.size())
+                for (const auto& replica : filterEnsemble.converterReplicas[i])
+                    stages[i].push_back(replica.get());
+        }
+        auto instances = [&stages, nStages](size_t stage) {
+            return stage < nStages ? static_cast<unsigned int>(stages[stage].size()) : 1u;
+        };
+
+        // links[i] feeds converters[i], the last one feeds the writer
+        std::vector<std::unique_ptr<EventLink>> links;
+        for (size_t i = 0; i <= nStages; i++)
+            links.push_back(std::make_unique<EventLink>(capacity, i == 0 ? 1u : instances(i - 1), instances(i)));
+        ReorderBuffer<TaggedEvent> reorderBuffer(runOptions.reorderWindow);
+        InFlightBudget budget(runOptions.maxEventsInFlight, runOptions.maxBytesInFlight);
+        AcceptedEvents accepted(nAccepted);
+
+        // called on an error or once enough events are written, stops all the stages
+        auto stop = [&] {
+            for (auto& link : links)
+                link->abort();
+            reorderBuffer.abort();
+            budget.abort();
+        };
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        auto fail = [&] {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (not error)
+                error = std::current_exception();
+            stop();
+        };
+
+        // threads are the generator, every converter instance and the writer
+        std::vector<std::string> names{"generator"};
+        for (size_t i = 0; i < nStages; i++)
+            for (size_t r = 0; r < stages[i].size(); r++)
+                names.push_back("converter " + std::to_string(i) + (stages[i].size() > 1 ? "." + std::to_string(r) : ""));
+        names.emplace_back("writer");
+        const auto placement = planPlacement(runOptions, names.size());
+        logPlacement(names, placement);
+
+        std::vector<std::thread> threads;
+        threads.emplace_back([&] {
+            try {
+                pinCurrentThread(placement[0]);
+                std::vector<TaggedEvent> events;
+                for (int k = 0; k < n and not accepted.done(); k++) {
+                    if (runOptions.ordered and not reorderBuffer.admit(k))
+                        break;
+                    TaggedEvent event{static_cast<size_t>(k), 0, generate(*filterEnsemble.generator, k)};
+                    if (budget.limited()) {
+                        event.bytes = eventBytes(*event.data);
+                        // don't wait for the budget while holding events
+                        if (not budget.tryAcquire(event.bytes) and
+                            ((not events.empty() and not links.front()->push(std::exchange(events, {}))) or
+                             not budget.acquire(event.bytes)))
+                            break;
+                    }
+                    events.push_back(std::move(event));
+                    if (events.size() == batchSize and not links.front()->push(std::exchange(events, {})))
+                        break;
+                }
+                if (not events.empty())
+                    links.front()->push(std::move(events));
+            } catch (...) {
+                fail();
+            }
+            links.front()->close();
+        });
+        size_t thread = 1;
+        for (size_t i = 0; i < nStages; i++) {
+            for (VConverter* converter : stages[i]) {
+                threads.emplace_back([&, i, converter, thread] {
+                    try {
+                        pinCurrentThread(placement[thread]);
+                        std::vector<TaggedEvent> events;
+                        ConverterBatch batch;
+                        while (links[i]->pop(events)) {
+                            batch.apply(*converter, events);
+                            if (not links[i + 1]->push(std::move(events)))
+                                break;
+                        }
+                    } catch (...) {
+                        fail();
+                    }
+                    links[i + 1]->close();
+                });
+                thread++;
+            }
         }
+
+        // the writer stage runs on the calling thread
+        try {
+            AffinityGuard guard(placement.back());
+            auto write = [this, &budget, &accepted](TaggedEvent&& event) {
+                if (event.data and accepted.admit())
+                    writeEvent(std::move(event.data));
+                if (budget.limited())
+                    budget.release(event.bytes);
+            };
+            std::vector<TaggedEvent> events;
+            EventBatch batch;
+            while (links.back()->pop(events)) {
+                if (runOptions.ordered) {
+                    for (auto& event : events)
+                        reorderBuffer.push(event.seq, std::move(event), write);
+                } else {
+                    for (auto& event : events)
+                        batch.push_back(std::move(event.data));
+                    accepted.admit(batch);
+                    writeBatch(batch);
+                    if (budget.limited())
+                        for (const auto& event : events)
+                            budget.release(event.bytes);
+                }
+                if (accepted.done()) {
+                    stop();
+                    break;
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+        for (auto& worker : threads)
+            worker.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    void ColaRunManager::runForked(int n, int nAccepted) const {
+        using MessageKind = SharedEventRing::MessageKind;
+        const unsigned int nWorkers = runOptions.workers;
+        const auto window = static_cast<std::int64_t>(std::max<size_t>(runOptions.reorderWindow, 1));
+        const auto maxEvents = static_cast<std::int64_t>(runOptions.maxEventsInFlight);
+        const auto maxBytes = static_cast<std::int64_t>(runOptions.maxBytesInFlight);
+        const bool budgeted = maxEvents > 0 or maxBytes > 0;
+        SharedRunControlMapping control;
+        // the same rules as of InFlightBudget, with the event awaited by the writer always admitted
+        auto acquireShared = [&](std::int64_t index, std::int64_t bytes) {
+            SharedRunControl& shared = *control;
+            for (Backoff backoff; not shared.abort; backoff.pause()) {
+                bool locked = false;
+                if (not shared.budgetLock.compare_exchange_weak(locked, true, std::memory_order_acquire))
+                    continue;
+                const auto events = shared.inFlightEvents.load();
+                const bool fits = events == 0 or (runOptions.ordered and index == shared.written) or
+                                  ((maxEvents == 0 or events < maxEvents) and
+                                   (maxBytes == 0 or shared.inFlightBytes + bytes <= maxBytes));
+                if (fits) {
+                    shared.inFlightEvents++;
+                    shared.inFlightBytes += bytes;
+                }
+                shared.budgetLock.store(false, std::memory_order_release);
+                if (fits)
+                    return true;
+            }
+            return false;
+        };
+        std::vector<std::unique_ptr<SharedEventRing>> rings;
+        for (unsigned int i = 0; i < nWorkers; i++)
+            rings.push_back(std::make_unique<SharedEventRing>(runOptions.sharedMemorySize));
+
+        const auto placement = planPlacement(runOptions, nWorkers);
+        std::vector<std::string> names;
+        for (unsigned int i = 0; i < nWorkers; i++)
+            names.push_back("worker process " + std::to_string(i));
+        logPlacement(names, placement);
+
+        // the children inherit the output buffer, which must not be written out twice
+        std::cout.flush();
+        std::vector<pid_t> children;
+        for (unsigned int i = 0; i < nWorkers; i++) {
+            const pid_t pid = fork();
+            if (pid < 0) {
+                control->abort = true;
+                for (auto child : children)
+                    waitpid(child, nullptr, 0);
+                throw std::runtime_error("ERROR in ColaRunManager: Couldn't fork a worker process.");
+            }
+            if (pid > 0) {
+                children.push_back(pid);
+                continue;
+            }
+
+            // worker process
+            auto& ring = *rings[i];
+            int status = 0;
+            try {
+                pinCurrentThread(placement[i]);
+                const auto ensemble = metaProcessor->parse(configName, false);
+                // the pool of the parent may have been locked by one of its threads at the time of the fork
+                const auto pool = makeEventPool(runOptions);
+                ensemble.generator->setEventPool(pool);
+                std::vector<char> buffer;
+                std::vector<TaggedEvent> events;
+                ConverterBatch batch;
+                // batches are consecutive events, in an ordered run they must fit into the reorder window
+                const auto batchSize = static_cast<std::int64_t>(std::max<size_t>(runOptions.batchSize, 1));
+                const std::int64_t step = runOptions.ordered ? std::min(batchSize, window) : batchSize;
+                for (std::int64_t first = control->nextEvent.fetch_add(step); first < n and not control->abort; first = control->nextEvent.fetch_add(step)) {
+                    const std::int64_t last = std::min<std::int64_t>(first + step, n) - 1;
+                    for (Backoff backoff; runOptions.ordered and last >= control->written + window; backoff.pause())
+                        if (control->abort)
+                            break;
+                    if (control->abort)
+                        break;
+                    for (std::int64_t index = first; index <= last; index++)
+                        events.push_back({static_cast<size_t>(index), 0, generate(*ensemble.generator, index)});
+                    for (const auto& converter : ensemble.converters)
+                        batch.apply(*converter, events);
+                    for (auto& event : events) {
+                        const auto index = static_cast<std::int64_t>(event.seq);
+                        // a rejected event still moves the writer on in an ordered run, but holds no budget
+                        if (not event.data) {
+                            if (not ring.send(MessageKind::rejected, index, nullptr, 0, control->abort))
+                                break;
+                            continue;
+                        }
+                        serializeEvent(*event.data, buffer);
+                        if (pool)
+                            pool->release(std::move(event.data));
+                        if (budgeted and not acquireShared(index, static_cast<std::int64_t>(buffer.size())))
+                            break;
+                        if (not ring.send(MessageKind::event, index, buffer.data(), buffer.size(), control->abort))
+                            break;
+                    }
+                    events.clear();
+                }
+                ring.send(MessageKind::done, 0, nullptr, 0, control->abort);
+            } catch (const std::exception& e) {
+                const std::string what = e.what();
+                ring.send(MessageKind::error, 0, what.data(), what.size(), control->abort);
+                status = 1;
+            } catch (...) {
+                status = 1;
+            }
+            std::cout.flush();
+            _exit(status);
+        }
+
+        // the parent process is the writer
+        ReorderBuffer<TaggedEvent> reorderBuffer(runOptions.reorderWindow);
+        AcceptedEvents accepted(nAccepted);
+        auto write = [this, &control, &accepted, budgeted](TaggedEvent&& event) {
+            const bool rejected = not event.data;
+            if (not rejected and accepted.admit())
+                writeEvent(std::move(event.data));
+            control->written++;
+            if (budgeted and not rejected) {
+                control->inFlightEvents--;
+                control->inFlightBytes -= static_cast<std::int64_t>(event.bytes);
+            }
+        };
+        std::vector<bool> finished(nWorkers, false);
+        std::vector<bool> exited(nWorkers, false);
+        auto alive = [&](unsigned int i) {
+            if (not exited[i] and waitpid(children[i], nullptr, WNOHANG) != 0)
+                exited[i] = true;
+            return not exited[i];
+        };
+
+        std::string error;
+        std::exception_ptr writerError;
+        unsigned int running = nWorkers;
+        SharedEventRing::MessageHeader header{};
+        std::vector<char> body;
+        for (Backoff backoff; running > 0;) {
+            bool progress = false;
+            for (unsigned int i = 0; i < nWorkers; i++) {
+                if (finished[i])
+                    continue;
+                bool received = false;
+                if (rings[i]->hasMessage()) {
+                    progress = true;
+                    received = rings[i]->receive(header, body, [&alive, i] { return alive(i); });
+                } else if (alive(i) or rings[i]->hasMessage()) {
+                    continue;
+                }
+
+                if (received and (header.kind == MessageKind::event or header.kind == MessageKind::rejected)) {
+                    if (writerError or accepted.done())
+                        continue;
+                    try {
+                        TaggedEvent event{static_cast<size_t>(header.seq), body.size(), nullptr};
+                        if (header.kind == MessageKind::event)
+                            event.data = deserializeEvent(body.data(), body.size(), eventPool ? eventPool->acquire() : nullptr);
+                        if (runOptions.ordered)
+                            reorderBuffer.push(event.seq, std::move(event), write);
+                        else
+                            write(std::move(event));
+                        // the workers give up their events once enough are written
+                        if (accepted.done())
+                            control->abort = true;
+                    } catch (...) {
+                        writerError = std::current_exception();
+                        control->abort = true;
+                    }
+                    continue;
+                }
+                // a worker stopped by the parent may not have reported its end
+                if ((not received and not accepted.done()) or (received and header.kind == MessageKind::error)) {
+                    if (error.empty())
+                        error = received ? std::string(body.begin(), body.end())
+                                         : "Worker process " + std::to_string(children[i]) + " terminated unexpectedly.";
+                    control->abort = true;
+                }
+                finished[i] = true;
+                running--;
+            }
+            if (progress)
+                backoff = Backoff();
+            else
+                backoff.pause();
+        }
+
+        for (unsigned int i = 0; i < nWorkers; i++)
+            if (not exited[i])
+                waitpid(children[i], nullptr, 0);
+
+        if (writerError)
+            std::rethrow_exception(writerError);
+        if (not error.empty())
+            throw std::runtime_error("ERROR in ColaRunManager: " + error);
+    }
+#else
+    void ColaRunManager::runForked(int, int) const {
+        throw std::runtime_error("ERROR in ColaRunManager: Forked mode is not supported on this platform.");
     }
+#endif
 
 } //cola
@@ -22,10 +22,20 @@
 #define COLA_COLA_HH
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <queue>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "LorentzVector.hh"
@@ -68,23 +78,261 @@ namespace cola {
     };
 
     /** Particle data.
-     *  A structure representing data about a single particle
+     *  A structure representing data about a single particle. The precision of its vectors is set by @tparam Type:
+     *  the pipeline works with double precision Particle, while ParticleF takes about half of the memory and can be used
+     *  by stages that are memory-bound rather than precision-bound, e.g. to buffer or write events. Particles of
+     *  different precision are converted explicitly with static_cast or convertParticles.
      */
-    struct Particle {
-        AZ getAZ() const;
+    template <typename Type>
+    struct ParticleImpl {
+        AZ getAZ() const { return pdgToAZ(pdgCode); }
 
-        LorentzVector position; /**< Position <t, x, y, z> vector. */
+        LorentzVectorImpl<Type> position; /**< Position <t, x, y, z> vector. */
 
-        LorentzVector momentum; /**< Momentum <e, x, y, z> vector. */
+        LorentzVectorImpl<Type> momentum; /**< Momentum <e, x, y, z> vector. */
 
         int pdgCode;    /**< PDG code of the particle. */
         ParticleClass pClass;   /**< Data about particle origin. See ParticleClass for more info.*/
+
+        template <typename Other>
+        explicit operator ParticleImpl<Other>() const {
+            return {static_cast<LorentzVectorImpl<Other>>(position), static_cast<LorentzVectorImpl<Other>>(momentum), pdgCode, pClass};
+        }
+    };
+
+    using Particle = ParticleImpl<double>;
+    using ParticleF = ParticleImpl<float>;
+
+    /** An allocator of event data sharing the ownership of its memory resource.
+     *  Unlike std::pmr::polymorphic_allocator, it keeps the resource alive for as long as any container uses it, so that
+     *  an event can own a per-event arena, which is freed in one shot with the last of its containers (see makeEvent).
+     *  The allocator follows containers on move and swap, while copies of containers allocate from the default resource,
+     *  so that copied events never share an arena. A default constructed allocator uses std::pmr::get_default_resource.
+     */
+    template <typename Type>
+    class ArenaAllocator {
+    public:
+        using value_type = Type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator() noexcept : memory(std::pmr::get_default_resource()) {}
+        /** Constructor.
+         * @param arena Memory resource to allocate from, e.g. std::pmr::monotonic_buffer_resource.
+         */
+        explicit ArenaAllocator(std::shared_ptr<std::pmr::memory_resource> arena) noexcept
+                : memory(arena ? arena.get() : std::pmr::get_default_resource()), arena(std::move(arena)) {}
+        template <typename Other>
+        ArenaAllocator(const ArenaAllocator<Other>& other) noexcept : memory(other.memory), arena(other.arena) {}
+
+        Type* allocate(size_t n) { return static_cast<Type*>(memory->allocate(n * sizeof(Type), alignof(Type))); }
+        void deallocate(Type* pointer, size_t n) noexcept { memory->deallocate(pointer, n * sizeof(Type), alignof(Type)); }
+
+        ArenaAllocator select_on_container_copy_construction() const noexcept { return {}; }
+
+        /** The memory resource in use. Temporary std::pmr containers of converters can allocate from the event arena
+         *  through it, as long as they don't outlive the event.
+         */
+        std::pmr::memory_resource* resource() const noexcept { return memory; }
+
+        template <typename Other>
+        bool operator==(const ArenaAllocator<Other>& other) const noexcept { return memory == other.memory or memory->is_equal(*other.memory); }
+        template <typename Other>
+        bool operator!=(const ArenaAllocator<Other>& other) const noexcept { return not (*this == other); }
+
+    private:
+        template <typename> friend class ArenaAllocator;
+
+        std::pmr::memory_resource* memory;
+        std::shared_ptr<std::pmr::memory_resource> arena;
     };
 
     /**
      * Convenient typedef for Particle vector.
      */
-    using EventParticles = std::vector<Particle>;
+    using EventParticles = std::vector<Particle, ArenaAllocator<Particle>>;
+
+    /** Convert particles to another precision.
+     *  Double precision particles are returned as EventParticles, so that they can be assigned back to an event. Pass
+     *  the allocator of the event particles to keep them in the event arena.
+     *  @tparam To Scalar type of the result.
+     *  @tparam ResultAllocator Allocator of the result, ArenaAllocator for double precision and std::allocator otherwise.
+     *  @param particles Particles to be converted.
+     *  @param allocator Allocator of the result.
+     *  @return Converted particles.
+     */
+    template <typename To,
+              typename ResultAllocator = std::conditional_t<std::is_same_v<To, double>, ArenaAllocator<ParticleImpl<To>>, std::allocator<ParticleImpl<To>>>,
+              typename From, typename Allocator>
+    std::vector<ParticleImpl<To>, ResultAllocator> convertParticles(const std::vector<ParticleImpl<From>, Allocator>& particles,
+                                                                    const ResultAllocator& allocator = ResultAllocator()) {
+        std::vector<ParticleImpl<To>, ResultAllocator> result(allocator);
+        result.reserve(particles.size());
+        for (const auto& particle : particles)
+            result.push_back(static_cast<ParticleImpl<To>>(particle));
+        return result;
+    }
+
+    /** Boost all the particles by the same velocity.
+     *  This is the bulk form of LorentzVectorImpl::boost, with the same results, as both go through LorentzBoost. The
+     *  Lorentz factor, or the rotation and the rapidity factors for velocities above 0.95, are computed once and the
+     *  kernel is chosen once, so the per-particle loop has neither branches nor calls and the compiler can vectorize it.
+     *  @param particles Particles to be boosted.
+     *  @param bx, by, bz Projections of the velocity.
+     *  @param positions Whether to boost the positions as well as the momenta.
+     */
+    template <typename Type, typename Allocator>
+    void boostParticles(std::vector<ParticleImpl<Type>, Allocator>& particles, Type bx, Type by, Type bz, bool positions = false) {
+        boostParticles(particles, LorentzBoost<Type>(bx, by, bz), positions);
+    }
+
+    /** Apply a prepared boost to all the particles, see LorentzBoost.
+     *  @param particles Particles to be boosted.
+     *  @param boost The boost.
+     *  @param positions Whether to boost the positions as well as the momenta.
+     */
+    template <typename Type, typename Allocator>
+    void boostParticles(std::vector<ParticleImpl<Type>, Allocator>& particles, const LorentzBoost<Type>& boost, bool positions = false) {
+        boost.apply(particles.begin(), particles.end(), [](ParticleImpl<Type>& particle) -> auto& { return particle.momentum; });
+        if (positions)
+            boost.apply(particles.begin(), particles.end(), [](ParticleImpl<Type>& particle) -> auto& { return particle.position; });
+    }
+
+    /** Check that all the momenta and positions are finite.
+     *  This is the check made once per event for kinematics computed with the unchecked methods, see Unchecked. A
+     *  component is infinite or NaN if all the bits of its exponent are set, in which case adding one to the exponent
+     *  carries into the sign bit. The eight components of a particle are tested this way as integers in one pass over
+     *  the particles, each of them in its own lane of bitwise or, so the loop has no comparisons and the compiler
+     *  vectorizes it even with SSE2. Being integer arithmetic, the check keeps working with -ffast-math.
+     *  @param particles Particles to be checked.
+     *  @return Whether all the components are finite.
+     */
+    template <typename Type, typename Allocator>
+    bool finiteKinematics(const std::vector<ParticleImpl<Type>, Allocator>& particles) {
+        static_assert(std::numeric_limits<Type>::is_iec559 and (sizeof(Type) == 4 or sizeof(Type) == 8));
+        using Bits = std::conditional_t<sizeof(Type) == 8, std::uint64_t, std::uint32_t>;
+        constexpr Bits exponent = sizeof(Type) == 8 ? Bits(0x7ff0000000000000) : Bits(0x7f800000);
+        constexpr Bits unit = exponent & ~(exponent << 1);
+        constexpr Bits sign = ~(~Bits(0) >> 1);
+        auto lane = [](Type value) {
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return (bits & exponent) + unit;
+        };
+        // separate accumulators rather than an array, which the compiler would keep in memory
+        Bits t = 0, x = 0, y = 0, z = 0, e = 0, px = 0, py = 0, pz = 0;
+        for (const auto& particle : particles) {
+            t |= lane(particle.position.t);
+            x |= lane(particle.position.x);
+            y |= lane(particle.position.y);
+            z |= lane(particle.position.z);
+            e |= lane(particle.momentum.e);
+            px |= lane(particle.momentum.x);
+            py |= lane(particle.momentum.y);
+            pz |= lane(particle.momentum.z);
+        }
+        return ((t | x | y | z | e | px | py | pz) & sign) == 0;
+    }
+
+    /** Particles that can be shared between events, with copy-on-write.
+     *  Generators often reuse a small set of sampled nuclear configurations, in which case every event would otherwise
+     *  hold its own copy of the same nucleons. Shared particles are kept in immutable reference-counted storage, which
+     *  copies of the object share and which can be assigned from SharedParticles::share of another event or from a
+     *  generator cache. Private particles stay in an EventParticles of the object itself, with its allocator, so they
+     *  are never handed to other threads: SharedParticles::share copies them to the default memory resource, as the
+     *  event arena or SmallEventStorage they may live in isn't thread-safe. Read access goes through const methods only,
+     *  while every modifying method first makes a private copy of shared particles. Iterators and references are only
+     *  valid until the next modification. Like the event it belongs to, the object isn't thread-safe, share() included.
+     */
+    class SharedParticles {
+    public:
+        using value_type = Particle;
+        using size_type = size_t;
+        using const_reference = const Particle&;
+        using const_iterator = EventParticles::const_iterator;
+
+        SharedParticles() = default;
+        /** Constructor taking private particles.
+         * @param particles Particles to be moved into the object, their allocator is kept.
+         */
+        SharedParticles(EventParticles&& particles) : local(std::move(particles)) {}
+        /** Constructor sharing immutable particles, e.g. a cached nuclear configuration.
+         * @param particles Particles to be shared. They are never modified.
+         */
+        SharedParticles(std::shared_ptr<const EventParticles> particles) : storage(std::move(particles)) {}
+
+        /** Share immutable particles, keeping the allocator and the capacity of the private particles.
+         * @param particles Particles to be shared. They are never modified.
+         */
+        SharedParticles& operator=(std::shared_ptr<const EventParticles> particles) {
+            local.clear();
+            storage = std::move(particles);
+            mirrored = false;
+            return *this;
+        }
+
+        /** Share the particles.
+         *  Private particles are copied to the default memory resource once, later calls share the same copy until the
+         *  particles are modified.
+         * @return Immutable particles, which stay valid after this object is modified or destroyed.
+         */
+        std::shared_ptr<const EventParticles> share() const {
+            if (not storage) {
+                // the copy allocates from the default memory resource, see ArenaAllocator::select_on_container_copy_construction
+                storage = std::make_shared<const EventParticles>(local);
+                mirrored = true;
+            }
+            return storage;
+        }
+        /** Whether the particles are shared with other events.
+         */
+        bool shared() const { return storage != nullptr; }
+
+        const EventParticles& get() const { return storage and not mirrored ? *storage : local; }
+        operator const EventParticles&() const { return get(); }
+
+        /** Get the particles for modification, copying them first if they are shared.
+         */
+        EventParticles& modify() {
+            if (storage and not mirrored)
+                local.assign(storage->begin(), storage->end());
+            storage.reset();
+            mirrored = false;
+            return local;
+        }
+
+        size_t size() const { return get().size(); }
+        bool empty() const { return get().empty(); }
+        size_t capacity() const { return get().capacity(); }
+        ArenaAllocator<Particle> get_allocator() const { return get().get_allocator(); }
+        const Particle* data() const { return get().data(); }
+        const Particle& operator[](size_t i) const { return get()[i]; }
+        const Particle& front() const { return get().front(); }
+        const Particle& back() const { return get().back(); }
+        const_iterator begin() const { return get().begin(); }
+        const_iterator end() const { return get().end(); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        void push_back(const Particle& particle) { modify().push_back(particle); }
+        template <typename... Args>
+        Particle& emplace_back(Args&&... args) { return modify().emplace_back(std::forward<Args>(args)...); }
+        void resize(size_t n) { modify().resize(n); }
+        void reserve(size_t n) { modify().reserve(n); }
+        void shrink_to_fit() { modify().shrink_to_fit(); }
+        /** Remove all the particles. Private particles keep their capacity, shared ones are only released.
+         */
+        void clear() {
+            storage.reset();
+            mirrored = false;
+            local.clear();
+        }
+
+    private:
+        EventParticles local;   // Private particles, used unless the storage holds other particles.
+        mutable std::shared_ptr<const EventParticles> storage;  // Shared particles, null if there are none.
+        mutable bool mirrored = false;  // Whether the storage is a copy of the private particles made by share().
+    };
 
     /** Initial state data.
      *  This structure contains data about initial state of any given event.
@@ -113,7 +361,7 @@ namespace cola {
         float phiRotB;          /** Diagnostic. Polar angle \f$\phi\f$ of rotation of the target nucleon. */
         float thetaRotB;        /** Diagnostic. Polar angle \f$\Theta\f$ of rotation of the target nucleon. */
 
-        EventParticles iniStateParticles;   /** The array of all Particles just before the event. */
+        SharedParticles iniStateParticles;  /** The array of all Particles just before the event, possibly shared with other events. */
     };
 
     /** A structure combining EventIniState and EventParticles of the event.
@@ -123,11 +371,98 @@ namespace cola {
         EventParticles particles;
     };
 
+    /** Create an empty event.
+     *  @param arenaSize Size in bytes of the first block of the per-event arena, which both particle vectors of the
+     *  event allocate from with a bump pointer. The arena is released when the vectors are destroyed. Zero to allocate
+     *  from the default memory resource.
+     *  @return A pointer to an empty EventData.
+     */
+    std::unique_ptr<EventData> makeEvent(size_t arenaSize = 0);
+
+    /** Check that all the particles of an event, including the initial state, have finite kinematics.
+     *  @param event The event.
+     *  @return Whether all the components are finite, see the overload for particles.
+     */
+    bool finiteKinematics(const EventData& event);
+
+    /** A memory resource with inline storage for the particle vectors of a small event.
+     *  It holds room for N particles for each of the two particle vectors of an event and passes larger requests to the
+     *  memory resource that was the default at its construction, so that an event spills to the heap only once it
+     *  outgrows the inline storage. A slot is given back when the vector moves to the heap. The resource is not
+     *  thread-safe, just like the event it belongs to. See makeSmallEvent.
+     */
+    template <size_t N>
+    class SmallEventStorage final : public std::pmr::memory_resource {
+        static_assert(N > 0, "SmallEventStorage needs room for at least one particle.");
+
+    public:
+        static constexpr size_t slotSize = N * sizeof(Particle);  /**< Number of bytes in every inline slot. */
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (bytes <= slotSize and alignment <= alignof(Particle))
+                for (auto& slot : slots)
+                    if (not slot.used) {
+                        slot.used = true;
+                        return slot.data;
+                    }
+            return upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+            for (auto& slot : slots)
+                if (pointer == slot.data) {
+                    slot.used = false;
+                    return;
+                }
+            upstream->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        struct Slot {
+            alignas(Particle) std::byte data[slotSize];
+            bool used = false;
+        };
+
+        Slot slots[2];
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+    };
+
+    /** Create an empty event with inline storage for N particles in each of its particle vectors.
+     *  Both vectors are given the capacity of N particles from SmallEventStorage, which is allocated together with its
+     *  reference count. Creating the event therefore takes two allocations, the event and its storage, and filling it
+     *  with up to N particles and N private initial state particles takes none, however the particles are added.
+     *  Sharing the initial state particles copies them to the heap (see SharedParticles::share). The storage moves with
+     *  the vectors, so recycled events (see EventPool) keep it.
+     *  @return A pointer to an empty EventData.
+     */
+    template <size_t N>
+    std::unique_ptr<EventData> makeSmallEvent() {
+        auto event = std::make_unique<EventData>();
+        ArenaAllocator<Particle> allocator(std::make_shared<SmallEventStorage<N>>());
+        event->particles = EventParticles(allocator);
+        event->iniState.iniStateParticles = EventParticles(allocator);
+        event->particles.reserve(N);
+        event->iniState.iniStateParticles.reserve(N);
+        return event;
+    }
+
+    /** A function creating empty events, e.g. makeSmallEvent.
+     */
+    using EventFactory = std::function<std::unique_ptr<EventData>()>;
+
+    /** A batch of events passed to filters at once.
+     */
+    using EventBatch = std::vector<std::unique_ptr<EventData>>;
+
     /** @}
      * \defgroup Interface Pure abstract classes used for dependency injection.
      * @{
      */
 
+    class EventPool;
+
     /** A common abstract parent class representing any model in the pipeline.
      *  A single model in the COLA-driven pipeline is named a Filter.
      */
@@ -161,6 +496,36 @@ namespace cola {
          *  @return A pointer to the EventData of the produced event.
          */
         virtual std::unique_ptr<EventData> operator()() = 0;
+
+        /** Set the pool VGenerator::newEvent takes events from. Called by ColaRunManager.
+         *  @param pool Pool of spare events, null to allocate every event anew.
+         */
+        void setEventPool(std::shared_ptr<EventPool> pool) { eventPool = std::move(pool); }
+
+        /** Set the index of the event the next VGenerator::operator() call produces. Called by ColaRunManager.
+         *  @param index Index of the event within the run.
+         */
+        void setEventIndex(std::int64_t index) { currentIndex = index; }
+
+    protected:
+        /** A method to get an empty event to be filled in VGenerator::operator().
+         *  The event is taken from the EventPool of the run if there is one, so that its particle vectors have the
+         *  capacity left by previous events. Generators are encouraged to use it instead of allocating events themselves.
+         *  @return A pointer to an empty EventData.
+         */
+        std::unique_ptr<EventData> newEvent() const;
+
+        /** Index of the event being produced within the run, to be used in VGenerator::operator().
+         *  Events are counted from zero across all the workers of the run, so the index doesn't depend on the worker
+         *  producing the event and may e.g. seed the random number generator of the event reproducibly. In ordered runs
+         *  it is the position of the event at the writer.
+         *  @return Index of the event.
+         */
+        std::int64_t eventIndex() const { return currentIndex; }
+
+    private:
+        std::shared_ptr<EventPool> eventPool;
+        std::int64_t currentIndex = 0;
     };
 
     inline VGenerator::~VGenerator() = default;
@@ -181,9 +546,18 @@ namespace cola {
         /** A method to process one event by the converter model.
          *  Users are supposed to override this method to process a single event by the converter model.
          *  @param data A pointer to the EventData to be processed.
-         *  @return A pointer to the EventData of the processed event.
+         *  @return A pointer to the EventData of the processed event, or a null pointer to reject the event. A rejected
+         *  event skips the rest of the chain and isn't written.
          */
         virtual std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) = 0;
+
+        /** A method to process a batch of events by the converter model.
+         *  ColaRunManager passes events to converters in batches (see RunOptions::batchSize). The default implementation
+         *  calls VConverter::operator() for every event; converters can override it to save the per-event dispatch or
+         *  to vectorize across events. The batch never holds events rejected earlier in the chain.
+         *  @param batch Events to be processed. Every pointer is replaced with the processed event, or reset to reject it.
+         */
+        virtual void processBatch(EventBatch& batch);
     };
 
     inline VConverter::~VConverter() = default;
@@ -210,6 +584,13 @@ namespace cola {
          *  @param data A pointer to the EventData to be saved.
          */
         virtual void operator()(std::unique_ptr<EventData>&& data) = 0;
+
+        /** A method to save a batch of events by the writer.
+         *  ColaRunManager passes events to the writer in batches (see RunOptions::batchSize), except for ordered runs.
+         *  The default implementation calls VWriter::operator() for every event.
+         *  @param batch Events to be saved. The writer may leave the events it doesn't take the ownership of in place.
+         */
+        virtual void writeBatch(EventBatch& batch);
     };
 
     inline VWriter::~VWriter() = default;
@@ -258,6 +639,7 @@ namespace cola {
         std::unique_ptr<VGenerator> generator;                  /**< Event generator. */
         std::vector<std::unique_ptr<VConverter>> converters;    /**< Vector of converters, applied step-by-step. */
         std::unique_ptr<VWriter> writer;                        /**< Writer to save the results. */
+        std::vector<std::vector<std::unique_ptr<VConverter>>> converterReplicas; /**< Additional instances of every converter, working in parallel in the pipelined run. */
     };
 
     /** A class for processing meta information.
@@ -292,11 +674,20 @@ namespace cola {
          *  (none is possible) and, finally, a <writer> element. Each element must have "name" attribute followed by
          *  any number of additional attributes. These attributes are then passed to the corresponding factory's VFactory::create
          *  method as a dictionary with keys being attribute names and values - attribute values.
+         *  A <converter> element may have a "replicas" attribute, which is not passed to the factory. It sets the
+         *  number of instances of the converter created for the pipelined run (see FilterEnsemble::converterReplicas).
+         *  The <writer> element may have an "async" attribute: if it is "true", the writer is wrapped into an AsyncWriter,
+         *  which saves events on a dedicated thread. The optional "asyncBuffer" attribute sets the number of events
+         *  buffered before the event loop has to wait for the writer (64 by default). Neither is passed to the factory.
          *  This method throws an error if a relevant factory isn't found or XML-file is malformed.
          *  @param fName Name with the configuration XML-file.
+         *  @param primary Whether to construct the writer and converter replicas. Replicas of the whole model, that are
+         *  used only to produce events, are parsed without them, so that the output is not opened several times.
+         *  @param replicateConverters Whether to construct the converter replicas of the primary ensemble. Only the
+         *  pipelined run uses them, ColaRunManager doesn't construct them for other run modes.
          *  @return A configured FilterEnsemble.
          */
-        FilterEnsemble parse(const std::string& fName) const;
+        FilterEnsemble parse(const std::string& fName, bool primary = true, bool replicateConverters = true) const;
 
     private:
         std::map<std::string, std::unique_ptr<VFactory>> generatorMap;
@@ -308,8 +699,63 @@ namespace cola {
         void regWrite(std::unique_ptr<VFactory>&& factory, const std::string& name){ writerMap.emplace(name, std::move(factory)); }
     };
 
+    /** An enum for choosing the way ColaRunManager distributes work.
+     */
+    enum class RunMode: char {
+        replicated, /**< Every worker runs the whole chain on its own FilterEnsemble replica. */
+        pipelined,  /**< The generator, every converter and the writer run on their own threads and pass events through bounded queues. */
+        forked      /**< Every worker is a forked process with its own FilterEnsemble, events are sent to the writer through shared memory. */
+    };
+
+    /** An enum for choosing how ColaRunManager pins its workers to CPUs.
+     */
+    enum class AffinityPolicy: char {
+        none,       /**< Workers are not pinned and may migrate between CPUs. */
+        compact,    /**< Workers are pinned to neighbouring CPUs, filling one NUMA node before moving to the next. */
+        scatter     /**< Workers are pinned to CPUs of different NUMA nodes in turn. */
+    };
+
+    /** Options of the ColaRunManager run.
+     */
+    struct RunOptions {
+        unsigned int workers = 1;   /**< Number of worker threads. Each worker runs the generator and converters of its own FilterEnsemble replica. */
+        RunMode mode = RunMode::replicated; /**< Parallelization scheme. See RunMode. */
+        size_t queueCapacity = 64;  /**< Number of events a queue between two pipeline stages can hold. */
+        bool ordered = false;       /**< Whether the writer receives events in the generation order. Unordered runs are faster. */
+        size_t reorderWindow = 256; /**< Maximal number of events processed ahead of the oldest unwritten one in an ordered run. */
+        size_t sharedMemorySize = 1 << 24;  /**< Size in bytes of the shared memory ring between every forked worker and the writer. */
+        AffinityPolicy affinity = AffinityPolicy::none; /**< Placement policy of workers (or pipeline stages) on CPUs. */
+        std::vector<int> cpus{};    /**< Explicit CPUs for workers (or pipeline stages) in their order. Overrides the policy if not empty. */
+        size_t maxEventsInFlight = 0;   /**< Maximal number of generated events not written yet, zero for no limit. */
+        size_t maxBytesInFlight = 0;    /**< Maximal memory held by generated events not written yet, zero for no limit. */
+        size_t eventPoolSize = 0;   /**< Maximal number of written events kept for reuse by VGenerator::newEvent, zero (the default) to disable recycling. Per worker if the replicated workers are pinned. */
+        size_t eventArenaSize = 0;  /**< Size in bytes of the first block of the arena of every event created by VGenerator::newEvent, zero for no arena. See makeEvent. */
+        size_t batchSize = 1;       /**< Number of events passed to converters and the writer at once. See VConverter::processBatch and VWriter::writeBatch. */
+        EventFactory eventFactory{};    /**< Function creating the events of VGenerator::newEvent, e.g. makeSmallEvent. Overrides eventArenaSize if set. */
+    };
+
     /** Manager class.
-     * Currently more of a boilerplate, but potentially useful to incorporate parallel computing.
+     * Runs the model either sequentially or in parallel. In the RunMode::replicated mode every worker thread owns a
+     * FilterEnsemble replica (generator and converters) built from the same XML-file, while the only writer is shared
+     * and called by one worker at a time. Events are handed out to workers dynamically with work stealing, so that no
+     * worker idles at the end of the run when the cost of events varies strongly. Note that generator replicas are
+     * constructed with identical parameters, so models relying on a random seed passed through the XML-file are
+     * expected to seed every instance differently by themselves. In the RunMode::pipelined mode the only FilterEnsemble
+     * is split into stages, each running on its own thread, so that slow converters overlap with the generator and the
+     * writer. Expensive converters can be given several instances (see FilterEnsemble::converterReplicas), which take
+     * events from a shared queue. The RunMode::forked mode is meant for models that are not thread-safe: every worker
+     * is a child process, which parses its own FilterEnsemble from the XML-file after the fork and streams serialized
+     * events to the writer in the parent process via shared memory. Workers can be pinned to CPUs (see
+     * RunOptions::affinity), in which case they also allocate memory on their local NUMA node. The chosen placement is
+     * printed at the start of the run. The number and the size of events between generation and writing can be bounded
+     * (see RunOptions::maxEventsInFlight and RunOptions::maxBytesInFlight), in which case producers wait for the writer
+     * to catch up instead of growing the memory footprint of the run. Events left in place by the writer can be
+     * recycled on request: they are returned to an EventPool, which generators draw from with VGenerator::newEvent (see
+     * RunOptions::eventPoolSize). These events may also be given a per-event arena (see RunOptions::eventArenaSize), or
+     * created by a custom function such as makeSmallEvent (see RunOptions::eventFactory). Filters receive events in
+     * batches (see RunOptions::batchSize), which lets them amortize the per-event overhead. Converters may reject
+     * events by returning a null pointer, in which case the rest of the chain is skipped for the event.
+     * ColaRunManager::runUntilAccepted runs the model until the writer has received a given number of events.
      */
     class ColaRunManager {
     public:
@@ -317,14 +763,50 @@ namespace cola {
         /** A constructor that moves the configured FilterEnsemble into the manager.
          * @param ensemble Configured model.
          */
-        explicit ColaRunManager(FilterEnsemble&& ensemble) : filterEnsemble(std::move(ensemble)) {}
+        explicit ColaRunManager(FilterEnsemble&& ensemble) : ColaRunManager(std::move(ensemble), RunOptions{}) {}
+        /** A constructor that moves the configured FilterEnsemble into the manager.
+         * Since the ensemble can't be replicated, only a single worker is allowed in the RunMode::replicated mode.
+         * @param ensemble Configured model.
+         * @param options Run options.
+         */
+        ColaRunManager(FilterEnsemble&& ensemble, const RunOptions& options);
+        /** A constructor that builds the model and its replicas for parallel run from an XML-file.
+         * @param processor MetaProcessor with all the needed filters registered. It must outlive the manager in the
+         * RunMode::forked mode.
+         * @param fName Name of the configuration XML-file. See MetaProcessor::parse.
+         * @param options Run options.
+         */
+        ColaRunManager(const MetaProcessor& processor, const std::string& fName, const RunOptions& options = {});
         ~ColaRunManager() = default;
         /** A method to run the resulting model @param n times.
          * @param n Number of runs.
          */
         void run(int n = 1) const;
+        /** A method to run the resulting model until the given number of events have passed all the converters.
+         * The writer receives exactly that many events unless the number of runs reaches the limit first. Events that
+         * are still in progress when the target is reached are discarded.
+         * @param nAccepted Number of events to write.
+         * @param maxEvents Maximal number of runs.
+         */
+        void runUntilAccepted(int nAccepted, int maxEvents = std::numeric_limits<int>::max()) const;
     private:
+        // A negative nAccepted means that the run isn't limited by the number of accepted events.
+        void dispatch(int n, int nAccepted) const;
+        void runSequential(int n, int nAccepted) const;
+        void runParallel(int n, int nAccepted) const;
+        void runPipelined(int n, int nAccepted) const;
+        void runForked(int n, int nAccepted) const;
+        void attachEventPool();
+        // written events left in place are released to the pool, the shared one by default
+        void writeEvent(std::unique_ptr<EventData>&& event, EventPool* pool = nullptr) const;
+        void writeBatch(EventBatch& batch, EventPool* pool = nullptr) const;
+
         FilterEnsemble filterEnsemble;
+        std::vector<FilterEnsemble> replicas;   // Additional workers' ensembles without writers.
+        RunOptions runOptions;
+        const MetaProcessor* metaProcessor = nullptr; // Used by forked workers to build their own ensembles.
+        std::string configName;
+        std::shared_ptr<EventPool> eventPool;   // Spare events shared by all the generators and the writer, unless workers are pinned.
     };
 } // cola
 
@@ -0,0 +1,127 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_COROUTINEGENERATOR_HH
+#define COLA_COROUTINEGENERATOR_HH
+
+#include "COLA.hh"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace cola {
+
+    /** A lazy stream of events produced by a coroutine.
+     *  A coroutine returning EventStream `co_yield`s events one by one and is resumed only when the next event is
+     *  requested, so that its local state (an open file, a pre-computed nucleus configuration) persists between events.
+     *  Exceptions thrown in the coroutine are rethrown by EventStream::next. Yielding a null event is an error, the
+     *  stream ends only when the coroutine returns.
+     */
+    class EventStream {
+    public:
+        struct promise_type {
+            std::unique_ptr<EventData> current;
+            std::exception_ptr error;
+
+            EventStream get_return_object() { return EventStream(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            // thrown into the coroutine, so that it is reported by next() like any other error of the model
+            std::suspend_always yield_value(std::unique_ptr<EventData> event) {
+                if (not event)
+                    throw std::invalid_argument("ERROR in EventStream: A null event was yielded.");
+                current = std::move(event);
+                return {};
+            }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        EventStream(EventStream&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+        EventStream& operator=(EventStream&& other) noexcept {
+            std::swap(handle, other.handle);
+            return *this;
+        }
+        EventStream(const EventStream&) = delete;
+        EventStream& operator=(const EventStream&) = delete;
+        ~EventStream() {
+            if (handle)
+                handle.destroy();
+        }
+
+        /** Resume the coroutine until it yields the next event.
+         *  Throws the error of the coroutine, including a yielded null event.
+         * @return The next event, or null if the coroutine has finished.
+         */
+        std::unique_ptr<EventData> next() {
+            if (not handle or handle.done())
+                return nullptr;
+            handle.resume();
+            auto& promise = handle.promise();
+            if (promise.error)
+                std::rethrow_exception(std::exchange(promise.error, nullptr));
+            if (handle.done())
+                return nullptr;
+            return std::move(promise.current);
+        }
+
+    private:
+        explicit EventStream(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    /** Generator abstract class for models written as coroutines.
+     *  Instead of VGenerator::operator(), users override VCoroutineGenerator::generate, a coroutine which `co_yield`s
+     *  events (e.g. obtained with VGenerator::newEvent) in a loop. The coroutine is started on the first request and
+     *  resumed by every following one. Requesting an event after the coroutine has finished is an error.
+     *  Only available when the code including this header is compiled with C++20 coroutines.
+     */
+    class VCoroutineGenerator : public VGenerator {
+    public:
+        std::unique_ptr<EventData> operator()() final {
+            if (not stream)
+                stream.emplace(generate());
+            auto event = stream->next();
+            if (not event)
+                throw std::runtime_error("ERROR in VCoroutineGenerator: The event stream has ended.");
+            return event;
+        }
+
+    protected:
+        /** The coroutine producing events.
+         *  @return The stream of events.
+         */
+        virtual EventStream generate() = 0;
+
+    private:
+        std::optional<EventStream> stream;
+    };
+} // namespace cola
+
+#endif // defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#endif // COLA_COROUTINEGENERATOR_HH
@@ -0,0 +1,83 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "EventPool.hh"
+
+#include <memory_resource>
+
+namespace cola {
+
+    EventPool::EventPool(size_t capacity, size_t arenaSize) : capacity(capacity), arenaSize(arenaSize) {
+        events.reserve(capacity);
+    }
+
+    EventPool::EventPool(size_t capacity, EventFactory factory) : capacity(capacity), arenaSize(0), factory(std::move(factory)) {
+        events.reserve(capacity);
+    }
+
+    std::unique_ptr<EventData> EventPool::acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not events.empty()) {
+                auto event = std::move(events.back());
+                events.pop_back();
+                return event;
+            }
+        }
+        return factory ? factory() : makeEvent(arenaSize);
+    }
+
+    void EventPool::release(std::unique_ptr<EventData>&& event) {
+        if (not event)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (events.size() >= capacity) {
+                event.reset();
+                return;
+            }
+        }
+
+        // reset everything but the allocated particle storage
+        auto particles = std::move(event->particles);
+        auto iniStateParticles = std::move(event->iniState.iniStateParticles);
+        particles.clear();
+        iniStateParticles.clear();
+        if (dynamic_cast<std::pmr::monotonic_buffer_resource*>(particles.get_allocator().resource())) {
+            // an arena only grows, converter temporaries included, so the event gets a fresh one and the old arena is
+            // freed with the last of its vectors
+            ArenaAllocator<Particle> allocator(arenaSize > 0 ? std::make_shared<std::pmr::monotonic_buffer_resource>(arenaSize) : nullptr);
+            particles = EventParticles(allocator);
+            iniStateParticles = EventParticles(allocator);
+        }
+        *event = EventData{};
+        event->particles = std::move(particles);
+        event->iniState.iniStateParticles = std::move(iniStateParticles);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.size() < capacity)
+            events.push_back(std::move(event));
+    }
+
+    size_t EventPool::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return events.size();
+    }
+} // namespace cola
@@ -0,0 +1,78 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_EVENTPOOL_HH
+#define COLA_EVENTPOOL_HH
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "COLA.hh"
+
+namespace cola {
+
+    /** A thread-safe pool of spare EventData objects.
+     *  Events returned to the pool are reset to the state of a value-initialized EventData, but their particle vectors
+     *  keep the capacity, so that an event taken from the pool is filled without heap allocations once the pool has
+     *  warmed up. Generators take events from the pool with VGenerator::newEvent, and ColaRunManager returns the events
+     *  the writer has left in place. Recycled events keep their inline storage (see makeSmallEvent), if any, while events
+     *  with an arena (see makeEvent) are given a fresh one of the size the pool was constructed with, or none, so that
+     *  the memory taken from the arena doesn't pile up over the recycled events.
+     */
+    class EventPool {
+    public:
+        /** Constructor.
+         * @param capacity Maximal number of spare events kept in the pool. Events released to a full pool are deleted.
+         * @param arenaSize Size of the first arena block of events created by the pool, zero for no arena. See makeEvent.
+         */
+        explicit EventPool(size_t capacity, size_t arenaSize = 0);
+        /** Constructor.
+         * @param capacity Maximal number of spare events kept in the pool. Events released to a full pool are deleted.
+         * @param factory Function creating new events when the pool is empty, e.g. makeSmallEvent.
+         */
+        EventPool(size_t capacity, EventFactory factory);
+        EventPool(const EventPool&) = delete;
+        EventPool& operator=(const EventPool&) = delete;
+
+        /** Take an empty event from the pool, or create a new one if the pool is empty.
+         * @return An empty event.
+         */
+        std::unique_ptr<EventData> acquire();
+
+        /** Return an event to the pool.
+         * @param event Event that is no longer needed. Null pointers are ignored.
+         */
+        void release(std::unique_ptr<EventData>&& event);
+
+        /** Number of spare events in the pool.
+         */
+        size_t size() const;
+
+    private:
+        const size_t capacity;
+        const size_t arenaSize;
+        const EventFactory factory;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<EventData>> events;
+    };
+} // namespace cola
+
+#endif // COLA_EVENTPOOL_HH
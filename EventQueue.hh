@@ -0,0 +1,418 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef COLA_EVENTQUEUE_HH
+#define COLA_EVENTQUEUE_HH
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace cola {
+
+    /** Exponential backoff for polling lock-free queues.
+     *  Busy-waits for a short while, then yields the core, and finally sleeps, so that a stage waiting for a slow
+     *  neighbour doesn't burn a core for long.
+     */
+    class Backoff {
+    public:
+        void pause() {
+            if (count < spinLimit) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__)
+                asm volatile("yield");
+#endif
+            } else if (count < yieldLimit) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            ++count;
+        }
+
+    private:
+        static constexpr unsigned int spinLimit = 64;
+        static constexpr unsigned int yieldLimit = 128;
+        unsigned int count = 0;
+    };
+
+    /** Closing and blocking operations shared by the lock-free queues.
+     *  The derived queue provides non-blocking tryPush and tryPop. This class adds blocking push and pop, which poll
+     *  with Backoff, as well as closing by producers and aborting.
+     */
+    template <typename Queue, typename Type>
+    class PollingQueue {
+    public:
+        explicit PollingQueue(unsigned int producers) : producers(producers) {}
+
+        /** Push an item, waiting while the queue is full.
+         * @param item Item to be moved into the queue.
+         * @return False if the queue was aborted.
+         */
+        bool push(Type&& item) {
+            for (Backoff backoff; not queue().tryPush(std::move(item)); backoff.pause())
+                if (aborted.load(std::memory_order_relaxed))
+                    return false;
+            return true;
+        }
+
+        /** Pop an item, waiting while the queue is empty.
+         * @param item Item to be moved from the queue.
+         * @return False if the queue was aborted or is closed and drained.
+         */
+        bool pop(Type& item) {
+            for (Backoff backoff; not queue().tryPop(item); backoff.pause()) {
+                if (aborted.load(std::memory_order_relaxed))
+                    return false;
+                // all pushes happen before the last close, so one more attempt sees everything
+                if (producers.load(std::memory_order_acquire) == 0)
+                    return queue().tryPop(item);
+            }
+            return true;
+        }
+
+        /** Mark that one of the producers has finished.
+         */
+        void close() { producers.fetch_sub(1, std::memory_order_acq_rel); }
+
+        /** Abort the queue, making all waiting producers and consumers return.
+         */
+        void abort() { aborted.store(true, std::memory_order_relaxed); }
+
+    private:
+        Queue& queue() { return static_cast<Queue&>(*this); }
+
+        std::atomic<unsigned int> producers;
+        std::atomic<bool> aborted{false};
+    };
+
+    /** Size of a cache line, used to avoid false sharing between producers and consumers.
+     */
+    inline constexpr size_t cacheLineSize = 64;
+
+    /** A lock-free bounded multi-producer multi-consumer queue.
+     *  An array-based ring where every cell carries a sequence number telling whether it is ready to be written or read
+     *  (D. Vyukov's bounded MPMC queue). Producers and consumers only contend on a single atomic index each.
+     *  The capacity is rounded up to a power of two.
+     */
+    template <typename Type>
+    class MPMCQueue : public PollingQueue<MPMCQueue<Type>, Type> {
+    public:
+        /** Constructor.
+         * @param capacity Minimal number of items stored in the queue.
+         * @param producers Number of producers expected to close the queue.
+         */
+        explicit MPMCQueue(size_t capacity, unsigned int producers = 1)
+                : PollingQueue<MPMCQueue<Type>, Type>(producers), cells(roundUp(capacity)), mask(cells.size() - 1) {
+            for (size_t i = 0; i < cells.size(); i++)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        /** Try to push an item without waiting. The item is left intact on failure.
+         * @return False if the queue is full.
+         */
+        bool tryPush(Type&& item) {
+            Cell* cell;
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            while (true) {
+                cell = &cells[pos & mask];
+                const auto diff = static_cast<std::intptr_t>(cell->sequence.load(std::memory_order_acquire)) -
+                                  static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->data = std::move(item);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Try to pop an item without waiting.
+         * @return False if the queue is empty.
+         */
+        bool tryPop(Type& item) {
+            Cell* cell;
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            while (true) {
+                cell = &cells[pos & mask];
+                const auto diff = static_cast<std::intptr_t>(cell->sequence.load(std::memory_order_acquire)) -
+                                  static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+            item = std::move(cell->data);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const { return cells.size(); }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            Type data;
+        };
+
+        static size_t roundUp(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            return size;
+        }
+
+        std::vector<Cell> cells;
+        const size_t mask;
+        alignas(cacheLineSize) std::atomic<size_t> enqueuePos{0};
+        alignas(cacheLineSize) std::atomic<size_t> dequeuePos{0};
+    };
+
+    /** A lock-free bounded single-producer single-consumer queue.
+     *  A cheaper alternative to MPMCQueue for links with exactly one producer and one consumer thread. Each side caches
+     *  the other side's index and only touches it when the ring looks full or empty. The capacity is rounded up to a
+     *  power of two.
+     */
+    template <typename Type>
+    class SPSCQueue : public PollingQueue<SPSCQueue<Type>, Type> {
+    public:
+        /** Constructor.
+         * @param capacity Minimal number of items stored in the queue.
+         */
+        explicit SPSCQueue(size_t capacity)
+                : PollingQueue<SPSCQueue<Type>, Type>(1), items(roundUp(capacity)), mask(items.size() - 1) {}
+
+        /** Try to push an item without waiting. The item is left intact on failure.
+         * Must only be called by the producer thread.
+         * @return False if the queue is full.
+         */
+        bool tryPush(Type&& item) {
+            const size_t tail = tailPos.load(std::memory_order_relaxed);
+            if (tail - cachedHead == items.size()) {
+                cachedHead = headPos.load(std::memory_order_acquire);
+                if (tail - cachedHead == items.size())
+                    return false;
+            }
+            items[tail & mask] = std::move(item);
+            tailPos.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Try to pop an item without waiting.
+         * Must only be called by the consumer thread.
+         * @return False if the queue is empty.
+         */
+        bool tryPop(Type& item) {
+            const size_t head = headPos.load(std::memory_order_relaxed);
+            if (head == cachedTail) {
+                cachedTail = tailPos.load(std::memory_order_acquire);
+                if (head == cachedTail)
+                    return false;
+            }
+            item = std::move(items[head & mask]);
+            headPos.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const { return items.size(); }
+
+    private:
+        static size_t roundUp(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            return size;
+        }
+
+        std::vector<Type> items;
+        const size_t mask;
+        alignas(cacheLineSize) std::atomic<size_t> headPos{0};
+        size_t cachedTail = 0;
+        alignas(cacheLineSize) std::atomic<size_t> tailPos{0};
+        size_t cachedHead = 0;
+    };
+
+    /** A buffer restoring the order of items processed in parallel.
+     *  Every item is tagged with its sequence number. Items are passed to the sink strictly in order, as soon as all
+     *  the preceding ones have arrived. Producers are expected to call ReorderBuffer::admit before starting to work on
+     *  an item, which blocks until the item fits into the window of the buffer. This bounds the number of items waiting
+     *  for their predecessors and guarantees that every pushed item has a free slot.
+     */
+    template <typename Type>
+    class ReorderBuffer {
+    public:
+        /** Constructor.
+         * @param window Maximal distance between the next item to be released and any admitted item.
+         */
+        explicit ReorderBuffer(size_t window) : slots(std::max<size_t>(window, 1)) {}
+
+        /** Block until the item with sequence number @param seq fits into the window.
+         * @return False if the buffer was aborted.
+         */
+        bool admit(size_t seq) {
+            std::unique_lock<std::mutex> lock(mutex);
+            advanced.wait(lock, [this, seq] { return seq < next + slots.size() or aborted; });
+            return not aborted;
+        }
+
+        /** Put an admitted item into the buffer and release all the items that are now in order.
+         * The sink is called under the lock of the buffer, so it is never called concurrently.
+         * @param seq Sequence number of the item.
+         * @param item Item to be moved into the buffer.
+         * @param sink Callable receiving the released items as rvalues.
+         */
+        template <typename Sink>
+        void push(size_t seq, Type&& item, Sink&& sink) {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[seq % slots.size()].emplace(std::move(item));
+            const size_t first = next;
+            for (auto* slot = &slots[next % slots.size()]; slot->has_value(); slot = &slots[next % slots.size()]) {
+                Type current = std::move(**slot);
+                slot->reset();
+                ++next;
+                released.store(next, std::memory_order_release);
+                sink(std::move(current));
+            }
+            if (next != first)
+                advanced.notify_all();
+        }
+
+        /** Sequence number of the next item to be released. Doesn't lock the buffer.
+         */
+        size_t expected() const { return released.load(std::memory_order_acquire); }
+
+        /** Abort the buffer, waking up all the waiting producers.
+         */
+        void abort() {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted = true;
+            advanced.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable advanced;
+        std::vector<std::optional<Type>> slots;
+        size_t next = 0;
+        std::atomic<size_t> released{0};
+        bool aborted = false;
+    };
+
+    /** A budget of events and bytes being processed at the same time.
+     *  Producers acquire a share of the budget for every event they pass downstream and block while it is exhausted;
+     *  the share is released once the event is written. This gives a predictable peak memory of a run: the budget can
+     *  only be exceeded by the events that producers hold while waiting. An event is always admitted when nothing else
+     *  is in flight, so that a single event larger than the whole budget doesn't stall the run.
+     */
+    class InFlightBudget {
+    public:
+        /** Constructor.
+         * @param maxEvents Maximal number of events in flight, zero for no limit.
+         * @param maxBytes Maximal number of bytes in flight, zero for no limit.
+         */
+        InFlightBudget(size_t maxEvents, size_t maxBytes) : maxEvents(maxEvents), maxBytes(maxBytes) {}
+
+        /** Whether the budget limits anything at all.
+         */
+        bool limited() const { return maxEvents > 0 or maxBytes > 0; }
+
+        /** Acquire a share for an event, blocking while the budget is exhausted.
+         * @param bytes Size of the event.
+         * @param urgent Predicate telling that the event must be admitted anyway, e.g. because the writer waits for
+         * exactly this event. It is checked again every time the budget is released.
+         * @return False if the budget was aborted.
+         */
+        template <typename Predicate>
+        bool acquire(size_t bytes, Predicate&& urgent) {
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&] { return fits(bytes) or aborted or urgent(); });
+            events++;
+            this->bytes += bytes;
+            return not aborted;
+        }
+
+        bool acquire(size_t bytes) {
+            return acquire(bytes, [] { return false; });
+        }
+
+        /** Acquire a share for an event if the budget allows it, without blocking.
+         * @param bytes Size of the event.
+         * @return False if the budget is exhausted or aborted.
+         */
+        bool tryAcquire(size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (aborted or not fits(bytes))
+                return false;
+            events++;
+            this->bytes += bytes;
+            return true;
+        }
+
+        /** Return a share of an event which has left the pipeline.
+         * @param bytes Size of the event it was acquired with.
+         */
+        void release(size_t bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            events--;
+            this->bytes -= bytes;
+            released.notify_all();
+        }
+
+        /** Abort the budget, waking up all the waiting producers.
+         */
+        void abort() {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted = true;
+            released.notify_all();
+        }
+
+    private:
+        bool fits(size_t size) const {
+            return events == 0 or ((maxEvents == 0 or events < maxEvents) and (maxBytes == 0 or bytes + size <= maxBytes));
+        }
+
+        std::mutex mutex;
+        std::condition_variable released;
+        const size_t maxEvents;
+        const size_t maxBytes;
+        size_t events = 0;
+        size_t bytes = 0;
+        bool aborted = false;
+    };
+} // namespace cola
+
+#endif // COLA_EVENTQUEUE_HH
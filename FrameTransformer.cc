@@ -0,0 +1,96 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "FrameTransformer.hh"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace cola {
+
+    FrameTransformer::FrameTransformer(double nucleonMass, size_t cacheSize) : nucleonMass(nucleonMass), cacheSize(cacheSize) {
+        if (not (nucleonMass > 0))
+            throw std::invalid_argument("ERROR in FrameTransformer: Nucleon mass must be positive.");
+        if (cacheSize == 0)
+            throw std::invalid_argument("ERROR in FrameTransformer: Cache size must be positive.");
+        cache.reserve(cacheSize);
+    }
+
+    double FrameTransformer::rapidity(const EventIniState& iniState, Frame frame) {
+        return frames(iniState).rapidities[static_cast<int>(frame)];
+    }
+
+    const LorentzBoost<double>& FrameTransformer::boost(const EventIniState& iniState, Frame from, Frame to) {
+        return frames(iniState).boosts[static_cast<int>(from) * nFrames + static_cast<int>(to)];
+    }
+
+    void FrameTransformer::transform(EventData& event, Frame from, Frame to, bool positions) {
+        if (from == to)
+            return;
+        const auto& boost = this->boost(event.iniState, from, to);
+        boostParticles(event.particles, boost, positions);
+        if (not event.iniState.iniStateParticles.empty())
+            boostParticles(event.iniState.iniStateParticles.modify(), boost, positions);
+    }
+
+    const FrameTransformer::Frames& FrameTransformer::frames(const EventIniState& iniState) {
+        const Key key{iniState.pZA, iniState.pZB, iniState.energy};
+        if (last < cache.size() and cache[last].first == key)
+            return cache[last].second;
+        for (last = 0; last < cache.size(); last++)
+            if (cache[last].first == key)
+                return cache[last].second;
+
+        if (cache.size() < cacheSize) {
+            cache.emplace_back(key, makeFrames(iniState));
+        } else {
+            last = oldest;
+            oldest = (oldest + 1) % cacheSize;
+            cache[last] = {key, makeFrames(iniState)};
+        }
+        return cache[last].second;
+    }
+
+    FrameTransformer::Frames FrameTransformer::makeFrames(const EventIniState& iniState) const {
+        double pZA = iniState.pZA;
+        if (iniState.pZB == 0 and pZA == 0) {
+            // fixed target, the projectile is given by its kinetic energy per nucleon
+            if (not (iniState.energy >= 0))
+                throw std::invalid_argument("ERROR in FrameTransformer: Energy per nucleon must be non-negative, got " + std::to_string(iniState.energy) + ".");
+            pZA = std::sqrt(iniState.energy * (iniState.energy + 2 * nucleonMass));
+        }
+
+        Frames frames;
+        auto& rapidities = frames.rapidities;
+        rapidities[static_cast<int>(Frame::lab)] = 0;
+        rapidities[static_cast<int>(Frame::projectile)] = std::asinh(pZA / nucleonMass);
+        rapidities[static_cast<int>(Frame::target)] = std::asinh(iniState.pZB / nucleonMass);
+        // rapidities are additive, and nucleons of equal mass have the centre of mass half way between them
+        rapidities[static_cast<int>(Frame::nucleonNucleon)] =
+                (rapidities[static_cast<int>(Frame::projectile)] + rapidities[static_cast<int>(Frame::target)]) / 2;
+
+        // a vector at rest in frame `from` has the rapidity y_from - y_to in frame `to`
+        for (int from = 0; from < nFrames; from++)
+            for (int to = 0; to < nFrames; to++)
+                frames.boosts[from * nFrames + to] = LorentzBoost<double>::fromRapidity(rapidities[from] - rapidities[to]);
+        return frames;
+    }
+} // namespace cola
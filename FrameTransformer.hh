@@ -0,0 +1,115 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_FRAMETRANSFORMER_HH
+#define COLA_FRAMETRANSFORMER_HH
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "COLA.hh"
+
+namespace cola {
+
+    /** Reference frames of a collision. All of them move along Oz relative to each other.
+     */
+    enum class Frame {
+        lab,            /**< The frame in which EventIniState::pZA and EventIniState::pZB are given. */
+        nucleonNucleon, /**< The centre-of-mass frame of a projectile and a target nucleon. */
+        projectile,     /**< The rest frame of the projectile. */
+        target          /**< The rest frame of the target. */
+    };
+
+    /** Boosts of whole events between the frames of a collision.
+     *  The frames are found from the per-nucleon momenta of the initial state. A zero EventIniState::pZB means a fixed
+     *  target experiment, in which the target rests in the lab frame and EventIniState::energy is the kinetic energy
+     *  per nucleon of the projectile, as in "1.23A GeV". It is only used when EventIniState::pZA is zero as well.
+     *  Otherwise the beams collide with momenta pZA and pZB, while energy is \f$\sqrt{s_{NN}}\f$, which follows from them.
+     *
+     *  All the frames differ by rapidities along Oz, so the transformer keeps the rapidities of the frames and the
+     *  boosts between them for the last distinct initial states it has seen, a fixed number of them, so that generators
+     *  sampling the energy don't grow the cache without bound. Runs usually have a single initial state, so the boosts
+     *  are computed once per run rather than once per event. The boosts are built from rapidities, which keeps the
+     *  precision for LHC energies, see LorentzBoost::fromRapidity. The transformer is not thread-safe: each filter should
+     *  own one, which replicated filters do by construction.
+     */
+    class FrameTransformer {
+    public:
+        static constexpr double defaultNucleonMass = 0.938918; /**< Mean of the proton and the neutron masses in GeV. */
+        static constexpr size_t defaultCacheSize = 16;          /**< Number of initial states whose frames are kept. */
+
+        /** Constructor.
+         * @param nucleonMass Nucleon mass in the units of the momenta, GeV by default.
+         * @param cacheSize Number of distinct initial states whose frames are kept, the oldest one is replaced first.
+         */
+        explicit FrameTransformer(double nucleonMass = defaultNucleonMass, size_t cacheSize = defaultCacheSize);
+
+        /** Rapidity of a frame, measured in the lab frame.
+         * @param iniState Initial state defining the frames.
+         * @param frame The frame.
+         */
+        double rapidity(const EventIniState& iniState, Frame frame);
+
+        /** The boost taking vectors from one frame to another.
+         * @param iniState Initial state defining the frames.
+         * @param from Frame in which the vectors are given.
+         * @param to Frame to which the vectors are transformed.
+         * @return The boost, valid until the frames of cacheSize other initial states are computed.
+         */
+        const LorentzBoost<double>& boost(const EventIniState& iniState, Frame from, Frame to);
+
+        /** Boost all the particles of an event, including the initial state particles, from one frame to another.
+         *  Initial state particles shared with other events are copied first, see SharedParticles.
+         * @param event The event.
+         * @param from Frame the event is in.
+         * @param to Frame to transform the event to.
+         * @param positions Whether to boost the positions as well as the momenta.
+         */
+        void transform(EventData& event, Frame from, Frame to, bool positions = false);
+
+        void toNucleonNucleon(EventData& event, bool positions = false) { transform(event, Frame::lab, Frame::nucleonNucleon, positions); }
+        void toLab(EventData& event, bool positions = false) { transform(event, Frame::nucleonNucleon, Frame::lab, positions); }
+        void toProjectile(EventData& event, bool positions = false) { transform(event, Frame::lab, Frame::projectile, positions); }
+
+    private:
+        static constexpr int nFrames = 4;
+
+        struct Frames {
+            std::array<double, nFrames> rapidities;
+            std::array<LorentzBoost<double>, nFrames * nFrames> boosts;  // from * nFrames + to
+        };
+
+        using Key = std::tuple<double, double, double>;   // pZA, pZB and energy
+
+        const Frames& frames(const EventIniState& iniState);
+        Frames makeFrames(const EventIniState& iniState) const;
+
+        const double nucleonMass;
+        const size_t cacheSize;
+        std::vector<std::pair<Key, Frames>> cache;  // searched linearly, it holds a few states at most
+        size_t last = 0;    // index of the last state used
+        size_t oldest = 0;  // index of the state replaced next once the cache is full
+    };
+} // namespace cola
+
+#endif // COLA_FRAMETRANSFORMER_HH
@@ -0,0 +1,239 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_PARTICLECOLUMNS_HH
+#define COLA_PARTICLECOLUMNS_HH
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "COLA.hh"
+
+namespace cola {
+
+    /** Structure-of-arrays storage of particles.
+     *  Every component of Particle is kept in its own contiguous column, so that a loop touching only momenta reads only
+     *  the momentum columns and can be vectorized by the compiler. The container converts from and to EventParticles and
+     *  can also be read and written as a sequence of particles through proxy references and iterators, although the
+     *  columns should be used directly in hot loops.
+     */
+    class ParticleColumns {
+    public:
+        template <typename Columns>
+        class BasicReference;
+        template <typename Columns>
+        class BasicIterator;
+
+        using value_type = Particle;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = BasicReference<ParticleColumns>;
+        using const_reference = BasicReference<const ParticleColumns>;
+        using iterator = BasicIterator<ParticleColumns>;
+        using const_iterator = BasicIterator<const ParticleColumns>;
+
+        std::vector<double> e, px, py, pz;  /**< Momentum columns. */
+        std::vector<double> t, x, y, z;     /**< Position columns. */
+        std::vector<int> pdgCode;           /**< PDG code column. */
+        std::vector<ParticleClass> pClass;  /**< ParticleClass column. */
+
+        ParticleColumns() = default;
+        /** Constructor converting particles into columns.
+         * @param particles Particles to be converted.
+         */
+        explicit ParticleColumns(const EventParticles& particles) { assign(particles); }
+
+        /** Replace the contents with the particles.
+         * @param particles Particles to be converted.
+         */
+        void assign(const EventParticles& particles) {
+            resize(particles.size());
+            for (size_t i = 0; i < particles.size(); i++)
+                set(i, particles[i]);
+        }
+
+        /** Convert the columns back into particles.
+         * @param particles Particles to be overwritten. Their allocator is kept.
+         */
+        void toParticles(EventParticles& particles) const {
+            particles.resize(size());
+            for (size_t i = 0; i < size(); i++)
+                particles[i] = get(i);
+        }
+
+        /** Convert the columns back into particles.
+         * @return Particles allocated from the default memory resource.
+         */
+        EventParticles toParticles() const {
+            EventParticles particles;
+            toParticles(particles);
+            return particles;
+        }
+
+        size_t size() const { return pdgCode.size(); }
+        bool empty() const { return pdgCode.empty(); }
+
+        void reserve(size_t n) { forEachColumn([n](auto& column) { column.reserve(n); }); }
+        void resize(size_t n) { forEachColumn([n](auto& column) { column.resize(n); }); }
+        void clear() { forEachColumn([](auto& column) { column.clear(); }); }
+
+        void push_back(const Particle& particle) {
+            resize(size() + 1);
+            set(size() - 1, particle);
+        }
+
+        /** Boost all the particles by the same velocity, see boostParticles.
+         *  The loops run over the columns, so they are vectorized across particles.
+         * @param bx, by, bz Projections of the velocity.
+         * @param positions Whether to boost the positions as well as the momenta.
+         */
+        void boost(double bx, double by, double bz, bool positions = false) {
+            const LorentzBoost<double> boost(bx, by, bz);
+            boost.apply(e.data(), px.data(), py.data(), pz.data(), size());
+            if (positions)
+                boost.apply(t.data(), x.data(), y.data(), z.data(), size());
+        }
+
+        /** Gather a particle from the columns.
+         */
+        Particle get(size_t i) const {
+            return Particle{{t[i], x[i], y[i], z[i]}, {e[i], px[i], py[i], pz[i]}, pdgCode[i], pClass[i]};
+        }
+
+        /** Scatter a particle into the columns.
+         */
+        void set(size_t i, const Particle& particle) {
+            t[i] = particle.position.t;
+            x[i] = particle.position.x;
+            y[i] = particle.position.y;
+            z[i] = particle.position.z;
+            e[i] = particle.momentum.e;
+            px[i] = particle.momentum.x;
+            py[i] = particle.momentum.y;
+            pz[i] = particle.momentum.z;
+            pdgCode[i] = particle.pdgCode;
+            pClass[i] = particle.pClass;
+        }
+
+        reference operator[](size_t i) { return {this, i}; }
+        const_reference operator[](size_t i) const { return {this, i}; }
+
+        iterator begin() { return {this, 0}; }
+        iterator end() { return {this, size()}; }
+        const_iterator begin() const { return {this, 0}; }
+        const_iterator end() const { return {this, size()}; }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        /** A proxy reference to a particle in the columns.
+         *  It converts to Particle and, for a mutable container, can be assigned a Particle. Single components are
+         *  accessed without gathering the whole particle.
+         */
+        template <typename Columns>
+        class BasicReference {
+        public:
+            BasicReference(Columns* columns, size_t i) : columns(columns), i(i) {}
+            BasicReference(const BasicReference&) = default;
+
+            operator Particle() const { return columns->get(i); }
+
+            const BasicReference& operator=(const Particle& particle) const {
+                static_assert(not std::is_const_v<Columns>, "Can't assign to a particle of constant columns.");
+                columns->set(i, particle);
+                return *this;
+            }
+
+            // assignment of a proxy copies the particle, not the proxy
+            const BasicReference& operator=(const BasicReference& other) const { return *this = static_cast<Particle>(other); }
+
+            friend void swap(const BasicReference& a, const BasicReference& b) {
+                const Particle particle = a;
+                a = b;
+                b = particle;
+            }
+
+            LorentzVector momentum() const { return {columns->e[i], columns->px[i], columns->py[i], columns->pz[i]}; }
+            LorentzVector position() const { return {columns->t[i], columns->x[i], columns->y[i], columns->z[i]}; }
+            auto& pdgCode() const { return columns->pdgCode[i]; }
+            auto& pClass() const { return columns->pClass[i]; }
+            AZ getAZ() const { return pdgToAZ(columns->pdgCode[i]); }
+
+        private:
+            Columns* columns;
+            size_t i;
+        };
+
+        /** A random access iterator over the particles in the columns, yielding proxy references.
+         */
+        template <typename Columns>
+        class BasicIterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = Particle;
+            using difference_type = std::ptrdiff_t;
+            using reference = BasicReference<Columns>;
+            using pointer = void;
+
+            BasicIterator() = default;
+            BasicIterator(Columns* columns, size_t i) : columns(columns), i(i) {}
+
+            reference operator*() const { return {columns, i}; }
+            reference operator[](difference_type n) const { return {columns, i + n}; }
+
+            BasicIterator& operator++() { ++i; return *this; }
+            BasicIterator operator++(int) { auto copy = *this; ++i; return copy; }
+            BasicIterator& operator--() { --i; return *this; }
+            BasicIterator operator--(int) { auto copy = *this; --i; return copy; }
+            BasicIterator& operator+=(difference_type n) { i += n; return *this; }
+            BasicIterator& operator-=(difference_type n) { i -= n; return *this; }
+            BasicIterator operator+(difference_type n) const { return {columns, i + n}; }
+            BasicIterator operator-(difference_type n) const { return {columns, i - n}; }
+            friend BasicIterator operator+(difference_type n, const BasicIterator& it) { return it + n; }
+            difference_type operator-(const BasicIterator& other) const {
+                return static_cast<difference_type>(i) - static_cast<difference_type>(other.i);
+            }
+
+            bool operator==(const BasicIterator& other) const { return i == other.i; }
+            bool operator!=(const BasicIterator& other) const { return i != other.i; }
+            bool operator<(const BasicIterator& other) const { return i < other.i; }
+            bool operator>(const BasicIterator& other) const { return i > other.i; }
+            bool operator<=(const BasicIterator& other) const { return i <= other.i; }
+            bool operator>=(const BasicIterator& other) const { return i >= other.i; }
+
+        private:
+            Columns* columns = nullptr;
+            size_t i = 0;
+        };
+
+    private:
+        template <typename Function>
+        void forEachColumn(Function&& function) {
+            for (auto* column : {&e, &px, &py, &pz, &t, &x, &y, &z})
+                function(*column);
+            function(pdgCode);
+            function(pClass);
+        }
+    };
+} // namespace cola
+
+#endif // COLA_PARTICLECOLUMNS_HH
@@ -0,0 +1,229 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include "SharedMemory.hh"
+#include "EventQueue.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace cola {
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free and std::atomic<std::int64_t>::is_always_lock_free and
+                  std::atomic<bool>::is_always_lock_free, "Shared memory transport needs address-free atomics.");
+
+    // serialization
+
+    namespace {
+        template <typename Type>
+        void put(std::vector<char>& buffer, const Type& value) {
+            const auto* bytes = reinterpret_cast<const char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(Type));
+        }
+
+        template <typename Type>
+        void get(const char*& buffer, Type& value) {
+            std::memcpy(&value, buffer, sizeof(Type));
+            buffer += sizeof(Type);
+        }
+
+        void putParticles(std::vector<char>& buffer, const EventParticles& particles) {
+            put(buffer, static_cast<std::uint64_t>(particles.size()));
+            const auto* bytes = reinterpret_cast<const char*>(particles.data());
+            buffer.insert(buffer.end(), bytes, bytes + particles.size() * sizeof(Particle));
+        }
+
+        void getParticles(const char*& buffer, EventParticles& particles) {
+            std::uint64_t size;
+            get(buffer, size);
+            particles.resize(size);
+            std::memcpy(particles.data(), buffer, size * sizeof(Particle));
+            buffer += size * sizeof(Particle);
+        }
+
+        // both sides of the transport must enumerate the fields in the same order
+        template <typename State, typename Visitor>
+        void visitIniState(State& state, Visitor&& visit) {
+            visit(state.pdgCodeA);
+            visit(state.pdgCodeB);
+            visit(state.pZA);
+            visit(state.pZB);
+            visit(state.energy);
+            visit(state.sectNN);
+            visit(state.b);
+            visit(state.nColl);
+            visit(state.nCollPP);
+            visit(state.nCollPN);
+            visit(state.nCollNN);
+            visit(state.nPart);
+            visit(state.nPartA);
+            visit(state.nPartB);
+            visit(state.phiRotA);
+            visit(state.thetaRotA);
+            visit(state.phiRotB);
+            visit(state.thetaRotB);
+        }
+    }
+
+    void serializeEvent(const EventData& data, std::vector<char>& buffer) {
+        static_assert(std::is_trivially_copyable_v<Particle>, "Particles are transferred as raw bytes.");
+        buffer.clear();
+        visitIniState(data.iniState, [&buffer](const auto& field) { put(buffer, field); });
+        putParticles(buffer, data.iniState.iniStateParticles);
+        putParticles(buffer, data.particles);
+    }
+
+    std::unique_ptr<EventData> deserializeEvent(const char* buffer, size_t size, std::unique_ptr<EventData>&& data) {
+        const char* end = buffer + size;
+        if (not data)
+            data = std::make_unique<EventData>();
+        visitIniState(data->iniState, [&buffer](auto& field) { get(buffer, field); });
+        getParticles(buffer, data->iniState.iniStateParticles.modify());
+        getParticles(buffer, data->particles);
+        if (buffer != end)
+            throw std::runtime_error("ERROR in deserializeEvent: Malformed event data.");
+        return std::move(data);
+    }
+
+    // shared memory
+
+    namespace {
+        void* mapShared(size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+            void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                throw std::runtime_error("ERROR in SharedEventRing: Couldn't map " + std::to_string(size) + " bytes of shared memory.");
+            return mapping;
+#else
+            (void)size;
+            throw std::runtime_error("ERROR in SharedEventRing: Shared memory is not supported on this platform.");
+#endif
+        }
+
+        void unmapShared(void* mapping, size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+            munmap(mapping, size);
+#else
+            (void)mapping;
+            (void)size;
+#endif
+        }
+    }
+
+    SharedEventRing::SharedEventRing(size_t size)
+            : mappingSize(sizeof(Control) + std::max<size_t>(size, sizeof(MessageHeader))), capacity(mappingSize - sizeof(Control)) {
+        mapping = mapShared(mappingSize);
+        control = new (mapping) Control;
+        control->head.store(0, std::memory_order_relaxed);
+        control->tail.store(0, std::memory_order_relaxed);
+        buffer = static_cast<char*>(mapping) + sizeof(Control);
+    }
+
+    SharedEventRing::~SharedEventRing() {
+        control->~Control();
+        unmapShared(mapping, mappingSize);
+    }
+
+    bool SharedEventRing::send(MessageKind kind, std::uint64_t seq, const char* data, size_t size, const std::atomic<bool>& abort) {
+        const MessageHeader header{kind, seq, size};
+        return write(reinterpret_cast<const char*>(&header), sizeof(header), abort) and write(data, size, abort);
+    }
+
+    bool SharedEventRing::hasMessage() const {
+        return control->tail.load(std::memory_order_acquire) - control->head.load(std::memory_order_relaxed) >= sizeof(MessageHeader);
+    }
+
+    bool SharedEventRing::receive(MessageHeader& header, std::vector<char>& data, const std::function<bool()>& alive) {
+        if (not read(reinterpret_cast<char*>(&header), sizeof(header), alive))
+            return false;
+        data.resize(header.size);
+        return read(data.data(), header.size, alive);
+    }
+
+    bool SharedEventRing::write(const char* data, size_t size, const std::atomic<bool>& abort) {
+        Backoff backoff;
+        while (size > 0) {
+            const auto tail = control->tail.load(std::memory_order_relaxed);
+            const size_t free = capacity - (tail - control->head.load(std::memory_order_acquire));
+            if (free == 0) {
+                if (abort.load(std::memory_order_relaxed))
+                    return false;
+                backoff.pause();
+                continue;
+            }
+            backoff = Backoff();
+            const size_t offset = tail % capacity;
+            const size_t count = std::min({size, free, capacity - offset});
+            std::memcpy(buffer + offset, data, count);
+            control->tail.store(tail + count, std::memory_order_release);
+            data += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    size_t SharedEventRing::readSome(char* data, size_t size) {
+        const auto head = control->head.load(std::memory_order_relaxed);
+        const size_t available = control->tail.load(std::memory_order_acquire) - head;
+        const size_t offset = head % capacity;
+        const size_t count = std::min({size, available, capacity - offset});
+        std::memcpy(data, buffer + offset, count);
+        control->head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    bool SharedEventRing::read(char* data, size_t size, const std::function<bool()>& alive) {
+        Backoff backoff;
+        while (size > 0) {
+            const size_t count = readSome(data, size);
+            data += count;
+            size -= count;
+            if (count > 0) {
+                backoff = Backoff();
+            } else if (not alive()) {
+                // the producer could have written the rest right before exiting
+                for (size_t rest = readSome(data, size); rest > 0; rest = readSome(data, size)) {
+                    data += rest;
+                    size -= rest;
+                }
+                return size == 0;
+            } else {
+                backoff.pause();
+            }
+        }
+        return true;
+    }
+
+    SharedRunControlMapping::SharedRunControlMapping() {
+        control = new (mapShared(sizeof(SharedRunControl))) SharedRunControl{};
+    }
+
+    SharedRunControlMapping::~SharedRunControlMapping() {
+        control->~SharedRunControl();
+        unmapShared(control, sizeof(SharedRunControl));
+    }
+} // namespace cola
@@ -0,0 +1,145 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef COLA_SHAREDMEMORY_HH
+#define COLA_SHAREDMEMORY_HH
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "COLA.hh"
+#include "EventQueue.hh"
+
+namespace cola {
+
+    /** Serialize an event into a flat byte buffer, that can be sent to another process running the same binary.
+     * @param data Event to be serialized.
+     * @param buffer Buffer to be overwritten with the bytes of the event.
+     */
+    void serializeEvent(const EventData& data, std::vector<char>& buffer);
+
+    /** Restore an event serialized by serializeEvent.
+     * @param buffer Pointer to the serialized bytes.
+     * @param size Number of the serialized bytes.
+     * @param data Empty event to be filled, e.g. taken from an EventPool. A new one is allocated if it is null.
+     * @return Restored event.
+     */
+    std::unique_ptr<EventData> deserializeEvent(const char* buffer, size_t size, std::unique_ptr<EventData>&& data = nullptr);
+
+    /** A single-producer single-consumer byte ring in memory shared between a parent process and its forked children.
+     *  The ring is created in an anonymous shared mapping before fork and is used by one child to stream messages to
+     *  the parent. Messages larger than the ring are streamed in parts, so the only requirement is that the consumer
+     *  keeps reading.
+     */
+    class SharedEventRing {
+    public:
+        /** Kinds of messages sent through the ring.
+         */
+        enum class MessageKind: std::uint64_t {
+            event,    /**< A serialized event. */
+            rejected, /**< An event rejected by a converter, only its sequence number is sent. */
+            error,    /**< The text of an exception thrown in the child. */
+            done      /**< The child has finished its work. */
+        };
+
+        /** A header preceding every message.
+         */
+        struct MessageHeader {
+            MessageKind kind;
+            std::uint64_t seq;
+            std::uint64_t size;
+        };
+
+        /** Constructor. Maps the shared memory.
+         * @param size Number of bytes in the ring.
+         */
+        explicit SharedEventRing(size_t size);
+        SharedEventRing(const SharedEventRing&) = delete;
+        SharedEventRing& operator=(const SharedEventRing&) = delete;
+        ~SharedEventRing();
+
+        /** Send a message, waiting for free space while @param abort is not set.
+         * @return False if aborted.
+         */
+        bool send(MessageKind kind, std::uint64_t seq, const char* data, size_t size, const std::atomic<bool>& abort);
+
+        /** Check whether the header of the next message has arrived.
+         */
+        bool hasMessage() const;
+
+        /** Receive the next message. Must only be called when SharedEventRing::hasMessage returned true.
+         * @param header Header of the received message.
+         * @param data Buffer for the message body.
+         * @param alive Callable returning false if the producer has died and the message will never be completed.
+         * @return False if the producer has died.
+         */
+        bool receive(MessageHeader& header, std::vector<char>& data, const std::function<bool()>& alive);
+
+    private:
+        struct Control {
+            alignas(cacheLineSize) std::atomic<std::uint64_t> head;
+            alignas(cacheLineSize) std::atomic<std::uint64_t> tail;
+        };
+
+        bool write(const char* data, size_t size, const std::atomic<bool>& abort);
+        size_t readSome(char* data, size_t size);
+
+        bool read(char* data, size_t size, const std::function<bool()>& alive);
+
+        void* mapping;
+        size_t mappingSize;
+        Control* control;
+        char* buffer;
+        size_t capacity;
+    };
+
+    /** Shared memory block with atomics coordinating forked workers.
+     */
+    struct SharedRunControl {
+        std::atomic<std::int64_t> nextEvent{0};     /**< Next event index to be taken by a worker. */
+        std::atomic<std::int64_t> written{0};       /**< Number of events released to the writer in an ordered run. */
+        std::atomic<bool> abort{false};             /**< Set by the parent to stop all the workers. */
+        std::atomic<std::int64_t> inFlightEvents{0};    /**< Number of events sent by the workers and not written yet. */
+        std::atomic<std::int64_t> inFlightBytes{0};     /**< Serialized size of these events. */
+        std::atomic<bool> budgetLock{false};        /**< Taken by a worker checking and acquiring the in-flight budget. */
+    };
+
+    /** An owner of an anonymous shared mapping holding a SharedRunControl.
+     */
+    class SharedRunControlMapping {
+    public:
+        SharedRunControlMapping();
+        SharedRunControlMapping(const SharedRunControlMapping&) = delete;
+        SharedRunControlMapping& operator=(const SharedRunControlMapping&) = delete;
+        ~SharedRunControlMapping();
+
+        SharedRunControl* operator->() const { return control; }
+        SharedRunControl& operator*() const { return *control; }
+
+    private:
+        SharedRunControl* control;
+    };
+} // namespace cola
+
+#endif // COLA_SHAREDMEMORY_HH
@@ -0,0 +1,220 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef COLA_STATICENSEMBLE_HH
+#define COLA_STATICENSEMBLE_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "AsyncWriter.hh"
+#include "COLA.hh"
+#include "EventPool.hh"
+
+namespace cola {
+
+    /** A model pipeline with the filter types known at compile time.
+     *  The first template parameter is the generator, the last one is the writer and the ones in between are the
+     *  converters, all of them concrete filter classes. Filters are called by qualified names instead of through the
+     *  virtual VGenerator, VConverter and VWriter methods, so that the compiler can inline the whole chain into the
+     *  event loop. The ensemble can be built from the filters themselves or from a FilterEnsemble parsed from an XML-file
+     *  with the same chain, which makes it a drop-in replacement of the sequential ColaRunManager for fixed production
+     *  chains. Written events can be recycled the same way (see StaticEnsemble::setEventPool), and events are passed
+     *  to the filters in batches (see StaticEnsemble::setBatchSize). An AsyncWriter is flushed at the end of every run.
+     *  The filters must be of exactly the given types, not derived from them: the qualified calls would skip the
+     *  overriding methods.
+     */
+    template <typename Generator, typename... Filters>
+    class StaticEnsemble {
+        static_assert(sizeof...(Filters) > 0, "A StaticEnsemble needs a generator and a writer.");
+
+        static constexpr size_t nConverters = sizeof...(Filters) - 1;
+        template <size_t I>
+        using Filter = std::tuple_element_t<I, std::tuple<Filters...>>;
+        using Writer = Filter<nConverters>;
+
+        static_assert(std::is_base_of_v<VGenerator, Generator>, "The first filter of a StaticEnsemble must be a generator.");
+        static_assert(std::is_base_of_v<VWriter, Writer>, "The last filter of a StaticEnsemble must be a writer.");
+
+    public:
+        /** A constructor that takes the ownership of the filters.
+         *  Throws an error if a filter is null or of a type derived from the one of the StaticEnsemble.
+         * @param generator Event generator.
+         * @param filters Converters, applied step-by-step, followed by the writer.
+         */
+        explicit StaticEnsemble(std::unique_ptr<Generator> generator, std::unique_ptr<Filters>... filters)
+                : generator(std::move(generator)), filters(std::move(filters)...) {
+            checkConverters(std::make_index_sequence<nConverters>());
+            if (not matches<Generator>(this->generator) or not filtersMatch(std::make_index_sequence<nConverters + 1>()))
+                throw std::invalid_argument("ERROR in StaticEnsemble: Filters must be of exactly the types of the chain.");
+        }
+
+        /** A constructor that takes the filters of a configured FilterEnsemble.
+         *  Throws an error if the filters of the ensemble are not of the types of the StaticEnsemble. Converter replicas
+         *  are ignored.
+         * @param ensemble Configured model, e.g. built by MetaProcessor::parse.
+         */
+        explicit StaticEnsemble(FilterEnsemble&& ensemble) {
+            checkConverters(std::make_index_sequence<nConverters>());
+            if (ensemble.converters.size() != nConverters)
+                throw std::invalid_argument("ERROR in StaticEnsemble: Expected " + std::to_string(nConverters) +
+                                            " converters, got " + std::to_string(ensemble.converters.size()) + ".");
+            if (not matches<Generator>(ensemble.generator) or not matches<Writer>(ensemble.writer) or
+                not convertersMatch(ensemble, std::make_index_sequence<nConverters>()))
+                throw std::invalid_argument("ERROR in StaticEnsemble: Filter types of the ensemble don't match the chain.");
+            generator = take<Generator>(ensemble.generator);
+            takeConverters(ensemble, std::make_index_sequence<nConverters>());
+            std::get<nConverters>(filters) = take<Writer>(ensemble.writer);
+        }
+
+        /** Set the pool the written events are recycled to, like in ColaRunManager. Events aren't recycled by default.
+         * @param pool Pool of spare events, null to disable recycling.
+         */
+        void setEventPool(std::shared_ptr<EventPool> pool) {
+            eventPool = std::move(pool);
+            generator->setEventPool(eventPool);
+            if constexpr (std::is_same_v<Writer, AsyncWriter>)
+                std::get<nConverters>(filters)->setEventPool(eventPool);
+        }
+
+        /** Set the number of events passed to the converters and the writer at once, like RunOptions::batchSize.
+         *  Filters overriding VConverter::processBatch or VWriter::writeBatch receive whole batches, the other ones are
+         *  called for every event with the inlined calls.
+         * @param size Number of events in a batch, 1 by default.
+         */
+        void setBatchSize(size_t size) {
+            batchSize = std::max<size_t>(size, 1);
+        }
+
+        /** Produce a single event processed by all the converters.
+         * @return A pointer to the EventData of the event, null if a converter has rejected it.
+         */
+        std::unique_ptr<EventData> operator()() {
+            generator->setEventIndex(nextIndex++);
+            return convert(generator->Generator::operator()(), std::make_index_sequence<nConverters>());
+        }
+
+        /** A method to run the model @param n times.
+         * @param n Number of runs.
+         */
+        void run(int n = 1) {
+            EventBatch batch;
+            for (int k = 0; k < n;) {
+                for (; k < n and batch.size() < batchSize; k++) {
+                    generator->setEventIndex(nextIndex++);
+                    batch.push_back(generator->Generator::operator()());
+                }
+                convertBatch(batch, std::make_index_sequence<nConverters>());
+                writeBatch(batch);
+            }
+            // the run is over only when the events are saved
+            if constexpr (std::is_same_v<Writer, AsyncWriter>)
+                std::get<nConverters>(filters)->flush();
+        }
+
+    private:
+        template <size_t... I>
+        static void checkConverters(std::index_sequence<I...>) {
+            static_assert((std::is_base_of_v<VConverter, Filter<I>> and ...), "The filters between the generator and the writer of a StaticEnsemble must be converters.");
+        }
+
+        // a derived type doesn't match, since the qualified calls would run the methods of the base
+        template <typename Type, typename Base>
+        static bool matches(const std::unique_ptr<Base>& filter) {
+            return filter and typeid(*filter) == typeid(Type);
+        }
+
+        template <size_t... I>
+        bool filtersMatch(std::index_sequence<I...>) const {
+            return (matches<Filter<I>>(std::get<I>(filters)) and ...);
+        }
+
+        template <size_t... I>
+        static bool convertersMatch(const FilterEnsemble& ensemble, std::index_sequence<I...>) {
+            return (matches<Filter<I>>(ensemble.converters[I]) and ...);
+        }
+
+        template <typename Type, typename Base>
+        static std::unique_ptr<Type> take(std::unique_ptr<Base>& filter) {
+            return std::unique_ptr<Type>(static_cast<Type*>(filter.release()));
+        }
+
+        template <size_t... I>
+        void takeConverters(FilterEnsemble& ensemble, std::index_sequence<I...>) {
+            ((std::get<I>(filters) = take<Filter<I>>(ensemble.converters[I])), ...);
+        }
+
+        template <size_t... I>
+        std::unique_ptr<EventData> convert(std::unique_ptr<EventData>&& event, std::index_sequence<I...>) {
+            // a rejected event skips the rest of the chain
+            ((event = event ? std::get<I>(filters)->Filter<I>::operator()(std::move(event)) : nullptr), ...);
+            return std::move(event);
+        }
+
+        template <size_t... I>
+        void convertBatch(EventBatch& batch, std::index_sequence<I...>) {
+            (processBatch<I>(batch), ...);
+        }
+
+        // filters not overriding the batch methods are called for every event, so that the calls can be inlined
+        template <size_t I>
+        void processBatch(EventBatch& batch) {
+            auto& converter = std::get<I>(filters);
+            if constexpr (std::is_same_v<decltype(&Filter<I>::processBatch), void (VConverter::*)(EventBatch&)>) {
+                for (auto& event : batch)
+                    event = converter->Filter<I>::operator()(std::move(event));
+            } else {
+                converter->Filter<I>::processBatch(batch);
+            }
+            // a rejected event skips the rest of the chain
+            batch.erase(std::remove(batch.begin(), batch.end(), nullptr), batch.end());
+        }
+
+        void writeBatch(EventBatch& batch) {
+            auto& writer = std::get<nConverters>(filters);
+            if constexpr (std::is_same_v<decltype(&Writer::writeBatch), void (VWriter::*)(EventBatch&)>) {
+                for (auto& event : batch)
+                    writer->Writer::operator()(std::move(event));
+            } else {
+                writer->Writer::writeBatch(batch);
+            }
+            // the writer may have left the events in place
+            if (eventPool)
+                for (auto& event : batch)
+                    eventPool->release(std::move(event));
+            batch.clear();
+        }
+
+        std::unique_ptr<Generator> generator;
+        std::tuple<std::unique_ptr<Filters>...> filters;
+        std::shared_ptr<EventPool> eventPool;
+        size_t batchSize = 1;
+        std::int64_t nextIndex = 0;
+    };
+} // namespace cola
+
+#endif // COLA_STATICENSEMBLE_HH
@@ -0,0 +1,86 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include <COLA.hh>
+#include <StaticEnsemble.hh>
+#include <benchmark/benchmark.h>
+
+using namespace cola;
+
+namespace {
+    // Generator of a light event with a few nucleons.
+    class LightGenerator final : public VGenerator {
+    public:
+        std::unique_ptr<EventData> operator()() override {
+            auto event = newEvent();
+            for (int i = 0; i < 4; i++)
+                event->particles.push_back(Particle{{}, {938., 0., 0., 100. * i}, 2212, ParticleClass::spectatorA});
+            return event;
+        }
+    };
+
+    // Converter doing a trivial amount of work per event.
+    class ShiftConverter final : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            for (auto& particle : data->particles)
+                particle.momentum.z += 1.;
+            return std::move(data);
+        }
+    };
+
+    class SumWriter final : public VWriter {
+    public:
+        void operator()(std::unique_ptr<EventData>&& data) override {
+            for (const auto& particle : data->particles)
+                sum += particle.momentum.z;
+            benchmark::DoNotOptimize(sum);
+        }
+
+    private:
+        double sum = 0;
+    };
+
+    // The same chain of light filters run through the virtual interface and through a StaticEnsemble.
+    void BM_DynamicChain(benchmark::State& state) {
+        FilterEnsemble ensemble;
+        ensemble.generator = std::make_unique<LightGenerator>();
+        for (int i = 0; i < 4; i++)
+            ensemble.converters.push_back(std::make_unique<ShiftConverter>());
+        ensemble.writer = std::make_unique<SumWriter>();
+        ColaRunManager manager(std::move(ensemble));
+        for (auto _ : state)
+            manager.run(1024);
+        state.SetItemsProcessed(state.iterations() * 1024);
+    }
+
+    void BM_StaticChain(benchmark::State& state) {
+        StaticEnsemble<LightGenerator, ShiftConverter, ShiftConverter, ShiftConverter, ShiftConverter, SumWriter> ensemble(
+                std::make_unique<LightGenerator>(), std::make_unique<ShiftConverter>(), std::make_unique<ShiftConverter>(),
+                std::make_unique<ShiftConverter>(), std::make_unique<ShiftConverter>(), std::make_unique<SumWriter>());
+        for (auto _ : state)
+            ensemble.run(1024);
+        state.SetItemsProcessed(state.iterations() * 1024);
+    }
+}
+
+BENCHMARK(BM_DynamicChain);
+BENCHMARK(BM_StaticChain);
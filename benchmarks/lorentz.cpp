@@ -0,0 +1,175 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include <COLA.hh>
+#include <ParticleColumns.hh>
+#include <benchmark/benchmark.h>
+
+using namespace cola;
+
+namespace {
+    // Component-wise arithmetic through a member pointer table, as LorentzVector did before the SIMD kernels.
+    struct ScalarVector {
+        double e, x, y, z;
+
+        static inline constexpr std::array<double ScalarVector::*, 4> Fields_ = {&ScalarVector::e, &ScalarVector::x, &ScalarVector::y, &ScalarVector::z};
+
+        ScalarVector& operator+=(const ScalarVector& other) {
+            for (size_t i = 0; i < Fields_.size(); ++i)
+                this->*Fields_[i] += other.*Fields_[i];
+            return *this;
+        }
+        ScalarVector& operator-=(const ScalarVector& other) {
+            for (size_t i = 0; i < Fields_.size(); ++i)
+                this->*Fields_[i] -= other.*Fields_[i];
+            return *this;
+        }
+    };
+
+    template <typename Vector>
+    std::vector<Vector> makeVectors() {
+        std::mt19937 engine(1);
+        std::uniform_real_distribution<double> uniform(-1., 1.);
+        std::vector<Vector> vectors(1024);
+        for (auto& vector : vectors)
+            vector = Vector{10. + uniform(engine), uniform(engine), uniform(engine), uniform(engine)};
+        return vectors;
+    }
+
+    template <typename Vector>
+    void BM_Add(benchmark::State& state) {
+        auto vectors = makeVectors<Vector>();
+        const Vector shift{1., 0.5, 0.25, 0.125};
+        for (auto _ : state) {
+            for (auto& vector : vectors)
+                vector += shift;
+            benchmark::DoNotOptimize(vectors.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * vectors.size());
+    }
+
+    template <typename Vector>
+    void BM_Sub(benchmark::State& state) {
+        auto vectors = makeVectors<Vector>();
+        const Vector shift{1., 0.5, 0.25, 0.125};
+        for (auto _ : state) {
+            for (auto& vector : vectors)
+                vector -= shift;
+            benchmark::DoNotOptimize(vectors.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * vectors.size());
+    }
+
+    // nucleons of a Pb+Pb event
+    EventParticles makeNucleons() {
+        std::mt19937 engine(1);
+        std::uniform_real_distribution<double> uniform(-1., 1.);
+        EventParticles particles(416);
+        for (auto& particle : particles)
+            particle = Particle{{0., uniform(engine), uniform(engine), uniform(engine)},
+                                {940. + uniform(engine), uniform(engine), uniform(engine), 100. * uniform(engine)}, 2212, ParticleClass::spectatorA};
+        return particles;
+    }
+
+    // the argument is the velocity in thousandths: 400 takes the matrix form, 990 the rotation to the beam axis
+    // alternating boosts keep the momenta bounded
+    double velocity(const benchmark::State& state) {
+        return state.range(0) / 1000.;
+    }
+
+    void BM_BoostPerParticle(benchmark::State& state) {
+        auto particles = makeNucleons();
+        const double beta = velocity(state);
+        double sign = 1.;
+        for (auto _ : state) {
+            for (auto& particle : particles)
+                particle.momentum.boost(0., 0., sign * beta);
+            sign = -sign;
+            benchmark::DoNotOptimize(particles.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * particles.size());
+    }
+
+    void BM_BoostPerParticleUnchecked(benchmark::State& state) {
+        auto particles = makeNucleons();
+        const double beta = velocity(state);
+        double sign = 1.;
+        for (auto _ : state) {
+            for (auto& particle : particles)
+                particle.momentum.boost(0., 0., sign * beta, unchecked);
+            sign = -sign;
+            benchmark::DoNotOptimize(particles.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * particles.size());
+    }
+
+    // the check of the unchecked kernels, once per event
+    void BM_FiniteKinematics(benchmark::State& state) {
+        const auto particles = makeNucleons();
+        for (auto _ : state)
+            benchmark::DoNotOptimize(finiteKinematics(particles));
+        state.SetItemsProcessed(state.iterations() * particles.size());
+    }
+
+    void BM_BoostParticles(benchmark::State& state) {
+        auto particles = makeNucleons();
+        const double beta = velocity(state);
+        double sign = 1.;
+        for (auto _ : state) {
+            boostParticles(particles, 0., 0., sign * beta);
+            sign = -sign;
+            benchmark::DoNotOptimize(particles.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * particles.size());
+    }
+
+    void BM_BoostColumns(benchmark::State& state) {
+        ParticleColumns columns(makeNucleons());
+        const double beta = velocity(state);
+        double sign = 1.;
+        for (auto _ : state) {
+            columns.boost(0., 0., sign * beta);
+            sign = -sign;
+            benchmark::DoNotOptimize(columns.e.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * columns.size());
+    }
+}
+
+// LorentzVector uses AVX when the benchmarks are built for it, e.g. with -DCMAKE_CXX_FLAGS=-march=native, SSE2 otherwise
+BENCHMARK(BM_Add<ScalarVector>);
+BENCHMARK(BM_Add<LorentzVector>);
+BENCHMARK(BM_Sub<ScalarVector>);
+BENCHMARK(BM_Sub<LorentzVector>);
+BENCHMARK(BM_BoostPerParticle)->Arg(400)->Arg(990);
+BENCHMARK(BM_BoostPerParticleUnchecked)->Arg(400)->Arg(990);
+BENCHMARK(BM_FiniteKinematics);
+BENCHMARK(BM_BoostParticles)->Arg(400)->Arg(990);
+BENCHMARK(BM_BoostColumns)->Arg(400)->Arg(990);
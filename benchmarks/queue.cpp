@@ -0,0 +1,160 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <COLA.hh>
+#include <EventQueue.hh>
+#include <benchmark/benchmark.h>
+
+using namespace cola;
+
+namespace {
+    /** A bounded blocking queue protected by a mutex, the baseline for the lock-free queues.
+     *  Producers block while the queue is full and consumers block while it is empty. The queue is closed when every
+     *  one of its producers has called BoundedQueue::close, after which consumers drain the remaining items.
+     *  BoundedQueue::abort wakes up everyone waiting on the queue and makes all further operations fail.
+     */
+    template <typename Type>
+    class BoundedQueue {
+    public:
+        /** Constructor.
+         * @param capacity Maximal number of items stored in the queue.
+         * @param producers Number of producers expected to close the queue.
+         */
+        explicit BoundedQueue(size_t capacity, unsigned int producers = 1) : capacity(capacity), producers(producers) {}
+
+        /** Push an item, blocking while the queue is full.
+         * @param item Item to be moved into the queue.
+         * @return False if the queue was aborted.
+         */
+        bool push(Type&& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this] { return items.size() < capacity or aborted; });
+            if (aborted)
+                return false;
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        /** Pop an item, blocking while the queue is empty.
+         * @param item Item to be moved from the queue.
+         * @return False if the queue was aborted or is closed and drained.
+         */
+        bool pop(Type& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return not items.empty() or producers == 0 or aborted; });
+            if (aborted or items.empty())
+                return false;
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        /** Mark that one of the producers has finished.
+         */
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (producers > 0 and --producers == 0)
+                notEmpty.notify_all();
+        }
+
+        /** Abort the queue, waking up all producers and consumers.
+         */
+        void abort() {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted = true;
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<Type> items;
+        size_t capacity;
+        unsigned int producers;
+        bool aborted = false;
+    };
+
+    using Event = std::unique_ptr<EventData>;
+
+    template <typename Queue>
+    std::unique_ptr<Queue> makeQueue(size_t capacity, unsigned int producers) {
+        if constexpr (std::is_constructible_v<Queue, size_t, unsigned int>)
+            return std::make_unique<Queue>(capacity, producers);
+        else
+            return std::make_unique<Queue>(capacity);
+    }
+
+    // Pass a batch of events from producer threads to consumer threads through the queue.
+    template <typename Queue>
+    void BM_Transfer(benchmark::State& state) {
+        const auto nProducers = static_cast<unsigned int>(state.range(0));
+        const auto nConsumers = static_cast<unsigned int>(state.range(1));
+        const size_t nEvents = 1 << 16;
+        std::vector<Event> events(nEvents);
+        for (auto& event : events)
+            event = std::make_unique<EventData>();
+
+        for (auto _ : state) {
+            auto queue = makeQueue<Queue>(1024, nProducers);
+            std::vector<std::vector<Event>> received(nConsumers);
+            std::vector<std::thread> threads;
+            for (unsigned int p = 0; p < nProducers; p++) {
+                threads.emplace_back([&, p] {
+                    for (size_t i = p; i < nEvents; i += nProducers)
+                        queue->push(std::move(events[i]));
+                    queue->close();
+                });
+            }
+            for (unsigned int c = 0; c < nConsumers; c++) {
+                threads.emplace_back([&, c] {
+                    Event event;
+                    received[c].reserve(nEvents);
+                    while (queue->pop(event))
+                        received[c].push_back(std::move(event));
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+
+            // reuse the same events in the next iteration
+            events.clear();
+            for (auto& part : received)
+                for (auto& event : part)
+                    events.push_back(std::move(event));
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nEvents));
+    }
+}
+
+BENCHMARK(BM_Transfer<BoundedQueue<Event>>)->Args({1, 1})->Args({2, 2})->Args({4, 4})->UseRealTime();
+BENCHMARK(BM_Transfer<MPMCQueue<Event>>)->Args({1, 1})->Args({2, 2})->Args({4, 4})->UseRealTime();
+BENCHMARK(BM_Transfer<SPSCQueue<Event>>)->Args({1, 1})->UseRealTime();
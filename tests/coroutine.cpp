@@ -0,0 +1,107 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <string>
+
+#include <CoroutineGenerator.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+namespace {
+    // Generator streaming a fixed number of events, throwing at the end if asked to.
+    class StreamingGenerator final : public VCoroutineGenerator {
+    public:
+        StreamingGenerator(int nEvents, bool fail) : nEvents(nEvents), fail(fail) {}
+
+    protected:
+        EventStream generate() override {
+            for (int i = 0; i < nEvents; i++) {
+                auto event = newEvent();
+                event->iniState.nColl = i;
+                event->particles.resize(i % 5);
+                co_yield std::move(event);
+            }
+            if (fail)
+                throw std::runtime_error("stream failure");
+        }
+
+    private:
+        const int nEvents;
+        const bool fail;
+    };
+
+    // Generator yielding a null event in place of its second one.
+    class NullGenerator final : public VCoroutineGenerator {
+    protected:
+        EventStream generate() override {
+            co_yield newEvent();
+            co_yield nullptr;
+            co_yield newEvent();
+        }
+    };
+
+    class CollectingWriter final : public VWriter {
+    public:
+        std::vector<int> ids;
+
+        void operator()(std::unique_ptr<EventData>&& data) override { ids.push_back(data->iniState.nColl); }
+    };
+}
+
+TEST(VCoroutineGenerator, StreamsEvents) {
+    FilterEnsemble ensemble;
+    ensemble.generator = std::make_unique<StreamingGenerator>(50, false);
+    ensemble.writer = std::make_unique<CollectingWriter>();
+    auto* writer = static_cast<CollectingWriter*>(ensemble.writer.get());
+    ColaRunManager manager(std::move(ensemble));
+    manager.run(20);
+    manager.run(30);
+    ASSERT_EQ(writer->ids.size(), 50u);
+    for (int i = 0; i < 50; i++)
+        EXPECT_EQ(writer->ids[i], i);
+
+    EXPECT_THROW(manager.run(1), std::runtime_error);
+}
+
+TEST(VCoroutineGenerator, PropagatesErrors) {
+    StreamingGenerator generator(2, true);
+    EXPECT_EQ(generator()->iniState.nColl, 0);
+    EXPECT_EQ(generator()->iniState.nColl, 1);
+    try {
+        generator();
+        ADD_FAILURE() << "generator didn't throw";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "stream failure");
+    }
+    EXPECT_THROW(generator(), std::runtime_error);
+}
+
+TEST(VCoroutineGenerator, RejectsNullEvents) {
+    NullGenerator generator;
+    EXPECT_NE(generator(), nullptr);
+    try {
+        generator();
+        ADD_FAILURE() << "generator didn't throw";
+    } catch (const std::invalid_argument& e) {
+        EXPECT_NE(std::string(e.what()).find("null event"), std::string::npos) << e.what();
+    }
+    // the coroutine has finished with the error
+    EXPECT_THROW(generator(), std::runtime_error);
+}
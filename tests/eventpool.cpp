@@ -0,0 +1,230 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <set>
+
+#include <COLA.hh>
+#include <EventPool.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+namespace {
+    // Generator drawing events from the pool and remembering their addresses.
+    class PooledGenerator final : public VGenerator {
+    public:
+        static inline std::set<const EventData*> addresses;
+        static inline bool reused = true;
+        static inline std::mutex mutex;
+
+        std::unique_ptr<EventData> operator()() override {
+            auto event = newEvent();
+            std::lock_guard<std::mutex> lock(mutex);
+            reused = reused and event->particles.empty() and event->iniState.nColl == 0;
+            addresses.insert(event.get());
+            event->iniState.nColl = ++counter;
+            event->particles.resize(100, Particle{{}, {}, 2212, ParticleClass::produced});
+            return event;
+        }
+
+    private:
+        int counter = 0;
+    };
+
+    // Generator remembering which instance drew each event from the pool.
+    class OwnerGenerator final : public VGenerator {
+    public:
+        static inline std::map<const EventData*, std::set<const VGenerator*>> owners;
+        static inline std::mutex mutex;
+
+        std::unique_ptr<EventData> operator()() override {
+            auto event = newEvent();
+            std::lock_guard<std::mutex> lock(mutex);
+            owners[event.get()].insert(this);
+            event->particles.resize(100, Particle{{}, {}, 2212, ParticleClass::produced});
+            return event;
+        }
+    };
+
+    // Writer leaving the events in place.
+    class CountingWriter final : public VWriter {
+    public:
+        static inline int written = 0;
+
+        void operator()(std::unique_ptr<EventData>&& data) override {
+            written += data->particles.size() == 100;
+        }
+    };
+
+    template <typename Filter>
+    class Factory final : public VFactory {
+    public:
+        VFilter* create(const std::map<std::string, std::string>&) override { return new Filter; }
+    };
+}
+
+TEST(EventPool, KeepsCapacity) {
+    EventPool pool(2);
+    auto event = pool.acquire();
+    event->particles.resize(10);
+    event->iniState.iniStateParticles.resize(5);
+    event->iniState.b = 1;
+    const auto* address = event.get();
+    pool.release(std::move(event));
+    EXPECT_EQ(pool.size(), 1u);
+
+    event = pool.acquire();
+    EXPECT_EQ(event.get(), address);
+    EXPECT_TRUE(event->particles.empty());
+    EXPECT_GE(event->particles.capacity(), 10u);
+    EXPECT_GE(event->iniState.iniStateParticles.capacity(), 5u);
+    EXPECT_EQ(event->iniState.b, 0);
+
+    pool.release(std::make_unique<EventData>());
+    pool.release(std::make_unique<EventData>());
+    pool.release(std::move(event));
+    EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(EventPool, RecycledByRunManager) {
+    MetaProcessor processor;
+    processor.reg(std::make_unique<Factory<PooledGenerator>>(), "gen", FilterType::generator);
+    processor.reg(std::make_unique<Factory<CountingWriter>>(), "writer", FilterType::writer);
+    auto fName = ::testing::TempDir() + "pool.xml";
+    std::ofstream(fName) << R"(<cola><generator name="gen"/><writer name="writer"/></cola>)";
+
+    for (auto mode : {RunMode::replicated, RunMode::pipelined}) {
+        PooledGenerator::addresses.clear();
+        CountingWriter::written = 0;
+        RunOptions options{2};
+        options.mode = mode;
+        options.eventPoolSize = 64;
+        options.eventArenaSize = 1 << 12;
+        if (mode == RunMode::pipelined)
+            options.eventFactory = makeSmallEvent<8>;
+        ColaRunManager(processor, fName, options).run(1000);
+        EXPECT_EQ(CountingWriter::written, 1000);
+        EXPECT_TRUE(PooledGenerator::reused);
+        EXPECT_LT(PooledGenerator::addresses.size(), 200u);
+    }
+}
+
+TEST(EventPool, PerWorkerWhenPinned) {
+    MetaProcessor processor;
+    processor.reg(std::make_unique<Factory<OwnerGenerator>>(), "gen", FilterType::generator);
+    processor.reg(std::make_unique<Factory<CountingWriter>>(), "writer", FilterType::writer);
+    auto fName = ::testing::TempDir() + "pinnedpool.xml";
+    std::ofstream(fName) << R"(<cola><generator name="gen"/><writer name="writer"/></cola>)";
+
+    for (bool ordered : {false, true}) {
+        OwnerGenerator::owners.clear();
+        CountingWriter::written = 0;
+        RunOptions options{3};
+        options.ordered = ordered;
+        options.cpus = {0, 0, 0};
+        // no event is freed and its address taken by another allocation
+        options.eventPoolSize = 600;
+        ColaRunManager(processor, fName, options).run(600);
+        EXPECT_EQ(CountingWriter::written, 600);
+        // the reorder window can hold many events, but some of them are recycled
+        EXPECT_LT(OwnerGenerator::owners.size(), 600u);
+        // an event allocated by one worker is never reused by another
+        for (const auto& [address, generators] : OwnerGenerator::owners)
+            EXPECT_EQ(generators.size(), 1u);
+    }
+}
+
+TEST(EventArena, AllocatesFromArena) {
+    auto event = makeEvent(1 << 16);
+    auto* arena = event->particles.get_allocator().resource();
+    EXPECT_NE(arena, std::pmr::get_default_resource());
+    EXPECT_EQ(event->iniState.iniStateParticles.get_allocator().resource(), arena);
+
+    // temporary containers of converters can share the arena
+    {
+        std::pmr::vector<int> temporary(arena);
+        temporary.resize(10);
+    }
+    event->particles.resize(100);
+
+    // moved vectors keep the arena, copies don't
+    EventParticles moved = std::move(event->particles);
+    EXPECT_EQ(moved.get_allocator().resource(), arena);
+    EventParticles copied = moved;
+    EXPECT_EQ(copied.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(copied.size(), 100u);
+
+    // the arena lives as long as any of its vectors
+    event.reset();
+    moved.resize(1000);
+    EXPECT_EQ(moved.size(), 1000u);
+
+    EventPool pool(1, 1 << 10);
+    event = pool.acquire();
+    arena = event->particles.get_allocator().resource();
+    EXPECT_NE(arena, std::pmr::get_default_resource());
+    pool.release(std::move(event));
+    event = pool.acquire();
+    EXPECT_NE(event->particles.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(event->iniState.iniStateParticles.get_allocator().resource(), event->particles.get_allocator().resource());
+}
+
+TEST(EventArena, BoundedWhenRecycled) {
+    // keeps track of the memory the arenas take from the heap
+    class CountingResource final : public std::pmr::memory_resource {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t size, size_t alignment) override {
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, alignment);
+        }
+        void do_deallocate(void* pointer, size_t size, size_t alignment) override {
+            bytes -= size;
+            std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    } heap;
+
+    auto* previous = std::pmr::set_default_resource(&heap);
+    {
+        EventPool pool(2, 1 << 12);
+        size_t peak = 0;
+        for (int round = 0; round < 1000; round++) {
+            auto event = pool.acquire();
+            event->particles.resize(100);
+            {
+                // a temporary container of a converter allocating from the arena
+                std::pmr::vector<double> temporary(event->particles.get_allocator().resource());
+                temporary.resize(1000);
+            }
+            pool.release(std::move(event));
+            if (round == 10)
+                peak = heap.bytes;
+            EXPECT_LE(heap.bytes, 2 * peak + (1 << 16));
+        }
+    }
+    std::pmr::set_default_resource(previous);
+    EXPECT_EQ(heap.bytes, 0u);
+}
@@ -0,0 +1,125 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <cmath>
+#include <stdexcept>
+
+#include <FrameTransformer.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+namespace {
+    constexpr double m = FrameTransformer::defaultNucleonMass;
+
+    Particle nucleon(double pz) {
+        return Particle{{0, 0, 0, 0}, {std::sqrt(m * m + pz * pz), 0, 0, pz}, 2212, ParticleClass::spectatorA};
+    }
+
+    EventData makeEvent(double pZA, double pZB, double energy) {
+        EventData event{};
+        event.iniState.pZA = pZA;
+        event.iniState.pZB = pZB;
+        event.iniState.energy = energy;
+        event.particles = {nucleon(pZA), nucleon(pZB)};
+        return event;
+    }
+}
+
+TEST(FrameTransformer, FixedTarget) {
+    // projectile of 1.23A GeV kinetic energy hitting a target at rest
+    FrameTransformer transformer;
+    auto event = makeEvent(0, 0, 1.23);
+    const double pZA = std::sqrt(1.23 * (1.23 + 2 * m));
+    event.particles[0] = nucleon(pZA);
+    EXPECT_NEAR(transformer.rapidity(event.iniState, Frame::projectile), std::asinh(pZA / m), 1e-15);
+    EXPECT_EQ(transformer.rapidity(event.iniState, Frame::target), 0.);
+
+    transformer.toNucleonNucleon(event);
+    const double sqrtS = std::sqrt(2 * m * (m + 1.23 + m));
+    EXPECT_NEAR(event.particles[0].momentum.e, sqrtS / 2, 1e-12);
+    EXPECT_NEAR(event.particles[1].momentum.e, sqrtS / 2, 1e-12);
+    EXPECT_NEAR(event.particles[0].momentum.z + event.particles[1].momentum.z, 0, 1e-12);
+
+    // given momentum wins over the energy
+    EXPECT_NEAR(transformer.rapidity(makeEvent(pZA, 0, 100).iniState, Frame::projectile), std::asinh(pZA / m), 1e-15);
+    EXPECT_THROW(transformer.rapidity(makeEvent(0, 0, -1).iniState, Frame::projectile), std::invalid_argument);
+}
+
+TEST(FrameTransformer, Collider) {
+    FrameTransformer transformer;
+    // p+Pb at the LHC, the lead beam carries 6.8 TeV * 82 / 208 per nucleon
+    auto event = makeEvent(6800, -2680.77, 8160);
+    EXPECT_NEAR(transformer.rapidity(event.iniState, Frame::nucleonNucleon), 0.465, 1e-3);
+
+    const auto lab = event.particles;
+    transformer.toProjectile(event);
+    EXPECT_NEAR(event.particles[0].momentum.e, m, 1e-7);
+    EXPECT_NEAR(event.particles[0].momentum.z, 0, 1e-7);
+    EXPECT_LT(event.particles[1].momentum.z, -2680.77 * 6800 / m);
+
+    // the target beam has e + pz below the precision of e in the projectile frame, so go back through the NN frame
+    event.particles = lab;
+    transformer.toNucleonNucleon(event);
+    transformer.toLab(event);
+    for (size_t i = 0; i < lab.size(); i++) {
+        EXPECT_NEAR(event.particles[i].momentum.e, lab[i].momentum.e, 1e-9 * lab[i].momentum.e);
+        EXPECT_NEAR(event.particles[i].momentum.z, lab[i].momentum.z, 1e-9 * lab[i].momentum.e);
+    }
+}
+
+TEST(FrameTransformer, SharedInitialState) {
+    FrameTransformer transformer;
+    auto event = makeEvent(10, 0, 0);
+    event.iniState.iniStateParticles = EventParticles{nucleon(10), nucleon(0)};
+    const auto shared = event.iniState.iniStateParticles.share();
+    auto other = event;
+    other.iniState.iniStateParticles = shared;
+
+    transformer.toNucleonNucleon(event, true);
+    transformer.toLab(event, true);
+    EXPECT_NEAR(event.iniState.iniStateParticles[0].momentum.z, 10, 1e-12);
+    transformer.toNucleonNucleon(event);
+    EXPECT_NEAR(event.iniState.iniStateParticles[0].momentum.z, -event.iniState.iniStateParticles[1].momentum.z, 1e-12);
+    EXPECT_EQ(other.iniState.iniStateParticles[0].momentum.z, 10.);
+    EXPECT_EQ(event.particles[0].momentum, event.iniState.iniStateParticles[0].momentum);
+}
+
+TEST(FrameTransformer, Cache) {
+    FrameTransformer transformer;
+    const auto first = makeEvent(10, 0, 0).iniState;
+    const auto second = makeEvent(20, 0, 0).iniState;
+    const auto* boost = &transformer.boost(first, Frame::lab, Frame::nucleonNucleon);
+    EXPECT_NE(&transformer.boost(second, Frame::lab, Frame::nucleonNucleon), boost);
+    EXPECT_EQ(&transformer.boost(first, Frame::lab, Frame::nucleonNucleon), boost);
+    EXPECT_EQ(transformer.boost(first, Frame::target, Frame::target).gamma(), 1.);
+    EXPECT_THROW(FrameTransformer(0.), std::invalid_argument);
+    EXPECT_THROW(FrameTransformer(FrameTransformer::defaultNucleonMass, 0), std::invalid_argument);
+
+    // the oldest state is replaced once the cache is full
+    FrameTransformer bounded(FrameTransformer::defaultNucleonMass, 2);
+    const auto third = makeEvent(30, 0, 0).iniState;
+    const double rapidity = bounded.rapidity(first, Frame::nucleonNucleon);
+    const auto* slot = &bounded.boost(first, Frame::lab, Frame::nucleonNucleon);
+    bounded.rapidity(second, Frame::nucleonNucleon);
+    EXPECT_EQ(&bounded.boost(third, Frame::lab, Frame::nucleonNucleon), slot);
+    EXPECT_EQ(bounded.rapidity(third, Frame::nucleonNucleon), transformer.rapidity(third, Frame::nucleonNucleon));
+    EXPECT_EQ(bounded.rapidity(first, Frame::nucleonNucleon), rapidity);
+    EXPECT_EQ(bounded.rapidity(second, Frame::nucleonNucleon), transformer.rapidity(second, Frame::nucleonNucleon));
+}
@@ -18,6 +18,10 @@
 * SOFTWARE.
 */
 
+#include <array>
+#include <limits>
+#include <memory_resource>
+#include <random>
 #include <sstream>
 
 #include <COLA.hh>
@@ -85,3 +89,178 @@ TEST(LorentzVector, Arithmetic) {
     ss << vec1;
     EXPECT_EQ(ss.str(), "(0, 1, 2, 3)");
 }
+
+TEST(LorentzVector, MatchesScalarArithmetic) {
+    // vectorized arithmetic must give exactly the results of the component-wise one
+    std::mt19937 engine(42);
+    std::uniform_real_distribution<double> uniform(-1e3, 1e3);
+    for (int i = 0; i < 1000; i++) {
+        const LorentzVector a{uniform(engine), uniform(engine), uniform(engine), uniform(engine)};
+        const LorentzVector b{uniform(engine), uniform(engine), uniform(engine), uniform(engine)};
+        const double s = uniform(engine);
+        EXPECT_EQ(a + b, (LorentzVector{a.e + b.e, a.x + b.x, a.y + b.y, a.z + b.z}));
+        EXPECT_EQ(a - b, (LorentzVector{a.e - b.e, a.x - b.x, a.y - b.y, a.z - b.z}));
+        EXPECT_EQ(a * s, (LorentzVector{a.e * s, a.x * s, a.y * s, a.z * s}));
+        EXPECT_EQ(a / s, (LorentzVector{a.e / s, a.x / s, a.y / s, a.z / s}));
+        EXPECT_EQ(a.mag2(), a.t * a.t - (a.x * a.x + a.y * a.y + a.z * a.z));
+    }
+}
+
+TEST(LorentzVector, LorentzBoost) {
+    // the matrix form in long double is the reference for fast boosts, where it loses precision in double
+    auto reference = [](LorentzVector vector, double bx, double by, double bz) {
+        const long double b2 = (long double)bx * bx + (long double)by * by + (long double)bz * bz;
+        const long double ggamma = 1 / std::sqrt(1 - b2);
+        const long double gamma2 = (ggamma - 1) / b2;
+        const long double bp = bx * (long double)vector.x + by * (long double)vector.y + bz * (long double)vector.z;
+        return LorentzVector{static_cast<double>(ggamma * (vector.t + bp)),
+                             static_cast<double>(vector.x + gamma2 * bp * bx + ggamma * bx * vector.t),
+                             static_cast<double>(vector.y + gamma2 * bp * by + ggamma * by * vector.t),
+                             static_cast<double>(vector.z + gamma2 * bp * bz + ggamma * bz * vector.t)};
+    };
+
+    const LorentzVector vector{10, 1, 2, 3};
+    for (const auto& beta : std::vector<std::array<double, 3>>{{0, 0, 0.98}, {0.5, 0.5, 0.7}, {0, 0, -0.999}, {0.99, 0, 0}}) {
+        const LorentzBoost<> boost(beta[0], beta[1], beta[2]);
+        const auto boosted = boost(vector);
+        const auto expected = reference(vector, beta[0], beta[1], beta[2]);
+        EXPECT_NEAR(boosted.e, expected.e, 1e-12 * expected.e);
+        EXPECT_NEAR(boosted.x, expected.x, 1e-12 * expected.e);
+        EXPECT_NEAR(boosted.y, expected.y, 1e-12 * expected.e);
+        EXPECT_NEAR(boosted.z, expected.z, 1e-12 * expected.e);
+        EXPECT_NEAR(boosted.mag2(), vector.mag2(), 1e-9);
+        EXPECT_EQ(LorentzVector(vector).boost(beta[0], beta[1], beta[2]), boosted);
+
+        const auto restored = LorentzBoost<>(-beta[0], -beta[1], -beta[2])(boosted);
+        EXPECT_NEAR(restored.e, vector.e, 1e-9);
+        EXPECT_NEAR(restored.z, vector.z, 1e-9);
+    }
+
+    // a beam of 6.8 TeV protons: the boost from the rest frame restores it
+    const double m = 0.938272, p = std::sqrt(6800. * 6800. - m * m);
+    const auto beam = LorentzBoost<>::fromRapidity(std::log((6800 + p) / m));
+    EXPECT_NEAR(beam.gamma(), 6800 / m, 1e-9 * 6800 / m);
+    EXPECT_NEAR(beam.gammaBeta(), p / m, 1e-9 * 6800 / m);
+    const auto proton = beam(LorentzVector{m, 0, 0, 0});
+    EXPECT_NEAR(proton.e, 6800, 1e-9);
+    EXPECT_NEAR(proton.z, p, 1e-9);
+    const auto slow = LorentzBoost<>::fromRapidity(0.5, {0.6, 0, 0.8})(vector);
+    const auto expected = reference(vector, 0.6 * std::tanh(0.5), 0, 0.8 * std::tanh(0.5));
+    EXPECT_NEAR(slow.e, expected.e, 1e-12 * expected.e);
+    EXPECT_NEAR(slow.x, expected.x, 1e-12 * expected.e);
+
+    const Vector3<double> uz{0.48, -0.6, 0.64};
+    const auto rotation = Rotation3<>::fromUz(uz);
+    for (const auto& v : {Vector3<double>{1, 0, 0}, Vector3<double>{0.3, -2, 5}}) {
+        const auto rotated = rotation(v);
+        const auto expected = rotateUz(v, uz);
+        EXPECT_NEAR(rotated.x, expected.x, 1e-15);
+        EXPECT_NEAR(rotated.y, expected.y, 1e-15);
+        EXPECT_NEAR(rotated.z, expected.z, 1e-15);
+        const auto back = rotation.inverse()(rotated);
+        EXPECT_NEAR(back.x, v.x, 1e-15);
+        EXPECT_NEAR(back.z, v.z, 1e-15);
+    }
+    EXPECT_EQ(Rotation3<>::fromUz({0, 0, -1})({1, 2, 3}).x, -1.);
+    EXPECT_THROW(LorentzBoost<>(0.6, 0.8, 0), std::runtime_error);
+}
+
+TEST(LorentzVector, Unchecked) {
+    const LorentzVector vector{10, 1, 2, 3};
+    for (double beta : {0.3, 0.98}) {
+        auto checked = vector, fast = vector;
+        checked.boost(0.1 * beta, 0.2 * beta, std::sqrt(0.95) * beta);
+        fast.boost(0.1 * beta, 0.2 * beta, std::sqrt(0.95) * beta, unchecked);
+        EXPECT_EQ(fast, checked);
+    }
+
+    auto checked = vector, fast = vector;
+    checked.boostAxisRapidity(1.5, 2);
+    fast.boostAxisRapidity(1.5, 2, unchecked);
+    EXPECT_NEAR(fast.e, checked.e, 1e-12 * checked.e);
+    EXPECT_NEAR(fast.y, checked.y, 1e-12 * checked.e);
+    EXPECT_EQ(fast.z, checked.z);
+    // the unchecked rapidity boost is linear, so it also takes vectors which the checked one rejects
+    const LorentzVector spaceLike{1, 0, 0, 2};
+    EXPECT_THROW(LorentzVector(spaceLike).boostAxisRapidity(0.5), std::runtime_error);
+    EXPECT_NEAR(LorentzVector(spaceLike).boostAxisRapidity(0.5, 3, unchecked).mag2(), spaceLike.mag2(), 1e-12);
+
+    // superluminal boosts are reported once per event instead of thrown
+    EventParticles particles(10, Particle{{0, 0, 0, 0}, {10, 1, 2, 3}, 2212, ParticleClass::produced});
+    EXPECT_TRUE(finiteKinematics(particles));
+    particles[7].momentum.boost(0, 0, 1.5, unchecked);
+    EXPECT_FALSE(finiteKinematics(particles));
+    particles[7].momentum = {10, 1, 2, 3};
+    particles[3].position.boost(0, 0.6, 0.8, unchecked);
+    EXPECT_FALSE(finiteKinematics(particles));
+
+    EventData event{};
+    event.particles = {particles[0]};
+    EXPECT_TRUE(finiteKinematics(event));
+    event.iniState.iniStateParticles = std::move(particles);
+    EXPECT_FALSE(finiteKinematics(event));
+
+    // every component, the largest finite values and single precision
+    for (int k = 0; k < 8; k++) {
+        std::vector<Particle> single(3, Particle{{}, {}, 2212, ParticleClass::produced});
+        std::vector<ParticleF> singleF(3, ParticleF{{}, {}, 2212, ParticleClass::produced});
+        auto& vector = k < 4 ? single[1].position : single[1].momentum;
+        auto& vectorF = k < 4 ? singleF[1].position : singleF[1].momentum;
+        vector[k % 4] = -std::numeric_limits<double>::max();
+        vectorF[k % 4] = std::numeric_limits<float>::max();
+        EXPECT_TRUE(finiteKinematics(single));
+        EXPECT_TRUE(finiteKinematics(singleF));
+        vector[k % 4] = -std::numeric_limits<double>::infinity();
+        vectorF[k % 4] = std::numeric_limits<float>::quiet_NaN();
+        EXPECT_FALSE(finiteKinematics(single)) << k;
+        EXPECT_FALSE(finiteKinematics(singleF)) << k;
+    }
+}
+
+TEST(Particle, BulkBoost) {
+    std::mt19937 engine(7);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    EventParticles particles;
+    for (int i = 0; i < 100; i++)
+        particles.push_back(Particle{{uniform(engine), uniform(engine), uniform(engine), uniform(engine)},
+                                     {5. + uniform(engine), uniform(engine), uniform(engine), uniform(engine)}, 2212, ParticleClass::produced});
+
+    for (double beta : {0., 0.3, 0.97}) {
+        auto boosted = particles;
+        boostParticles(boosted, 0.1 * beta, -0.2 * beta, std::sqrt(0.95) * beta, true);
+        for (size_t i = 0; i < particles.size(); i++) {
+            auto momentum = particles[i].momentum;
+            auto position = particles[i].position;
+            momentum.boost(0.1 * beta, -0.2 * beta, std::sqrt(0.95) * beta);
+            position.boost(0.1 * beta, -0.2 * beta, std::sqrt(0.95) * beta);
+            EXPECT_EQ(boosted[i].momentum, momentum);
+            EXPECT_EQ(boosted[i].position, position);
+        }
+    }
+    EXPECT_THROW(boostParticles(particles, 0., 0., 1.), std::runtime_error);
+}
+
+TEST(Particle, Precision) {
+    const Particle particle{{1, 2, 3, 4}, {5.25, 0.1, 0.2, 0.3}, 1000020040, ParticleClass::spectatorA};
+    const auto single = static_cast<ParticleF>(particle);
+    EXPECT_LT(sizeof(ParticleF), sizeof(Particle));
+    EXPECT_EQ(single.momentum.e, 5.25f);
+    EXPECT_EQ(single.momentum.x, 0.1f);
+    EXPECT_EQ(single.getAZ(), particle.getAZ());
+
+    const auto restored = static_cast<Particle>(single);
+    EXPECT_EQ(restored.position, particle.position);
+    EXPECT_NEAR(restored.momentum.x, particle.momentum.x, 1e-7);
+
+    const auto converted = convertParticles<float>(EventParticles{particle, particle});
+    ASSERT_EQ(converted.size(), 2u);
+    EXPECT_EQ(converted[1].pdgCode, particle.pdgCode);
+    EXPECT_EQ(converted[1].pClass, particle.pClass);
+
+    auto arena = std::make_shared<std::pmr::monotonic_buffer_resource>();
+    EventParticles particles{ArenaAllocator<Particle>(arena)};
+    particles = convertParticles<double>(converted, particles.get_allocator());
+    ASSERT_EQ(particles.size(), 2u);
+    EXPECT_EQ(particles.get_allocator().resource(), arena.get());
+    EXPECT_EQ(particles[0].momentum.e, 5.25);
+}
@@ -0,0 +1,91 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <algorithm>
+#include <numeric>
+
+#include <ParticleColumns.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+namespace {
+    EventParticles makeParticles(int n) {
+        EventParticles particles;
+        for (int i = 0; i < n; i++)
+            particles.push_back(Particle{{1. * i, 2. * i, 3. * i, 4. * i}, {10. + i, 1, 2, 3}, 2212 + i, ParticleClass::spectatorA});
+        return particles;
+    }
+
+    bool equal(const Particle& a, const Particle& b) {
+        return a.position == b.position and a.momentum == b.momentum and a.pdgCode == b.pdgCode and a.pClass == b.pClass;
+    }
+}
+
+TEST(ParticleColumns, RoundTrip) {
+    const auto particles = makeParticles(17);
+    ParticleColumns columns(particles);
+    ASSERT_EQ(columns.size(), particles.size());
+    EXPECT_EQ(columns.e[5], 15.);
+    EXPECT_EQ(columns.z[5], 20.);
+
+    const auto restored = columns.toParticles();
+    ASSERT_EQ(restored.size(), particles.size());
+    for (size_t i = 0; i < particles.size(); i++)
+        EXPECT_TRUE(equal(restored[i], particles[i]));
+}
+
+TEST(ParticleColumns, ProxyAccess) {
+    const auto particles = makeParticles(10);
+    ParticleColumns columns(particles);
+
+    size_t i = 0;
+    for (Particle particle : std::as_const(columns))
+        EXPECT_TRUE(equal(particle, particles[i++]));
+    EXPECT_EQ(i, particles.size());
+
+    const double energy = std::accumulate(columns.begin(), columns.end(), 0., [](double sum, const auto& particle) {
+        return sum + particle.momentum().e;
+    });
+    EXPECT_EQ(energy, 145.);
+
+    columns[3] = particles[7];
+    EXPECT_TRUE(equal(columns[3], particles[7]));
+    columns[4].pdgCode() = 2112;
+    EXPECT_EQ(columns.pdgCode[4], 2112);
+    EXPECT_EQ(columns[4].getAZ(), AZ(1, 0));
+
+    std::reverse(columns.begin(), columns.end());
+    EXPECT_TRUE(equal(columns[0], particles[9]));
+    EXPECT_EQ(columns.end() - columns.begin(), 10);
+
+    columns.push_back(particles[0]);
+    EXPECT_EQ(columns.size(), 11u);
+    columns.clear();
+    EXPECT_TRUE(columns.empty());
+}
+
+TEST(ParticleColumns, Boost) {
+    auto particles = makeParticles(33);
+    ParticleColumns columns(particles);
+    columns.boost(0.1, 0.2, -0.5, true);
+    boostParticles(particles, 0.1, 0.2, -0.5, true);
+    for (size_t i = 0; i < particles.size(); i++)
+        EXPECT_TRUE(equal(columns[i], particles[i]));
+}
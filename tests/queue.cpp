@@ -0,0 +1,153 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <EventQueue.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+TEST(ReorderBuffer, ReleasesInOrder) {
+    const size_t n = 10000;
+    ReorderBuffer<std::unique_ptr<size_t>> buffer(16);
+    std::vector<size_t> released;
+    auto sink = [&released](std::unique_ptr<size_t>&& item) { released.push_back(*item); };
+
+    std::atomic<size_t> counter{0};
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 4; w++) {
+        workers.emplace_back([&] {
+            for (size_t seq = counter++; seq < n; seq = counter++) {
+                ASSERT_TRUE(buffer.admit(seq));
+                buffer.push(seq, std::make_unique<size_t>(seq), sink);
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    ASSERT_EQ(released.size(), n);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(released[i], i);
+}
+
+TEST(InFlightBudget, BlocksUntilReleased) {
+    InFlightBudget budget(2, 100);
+    EXPECT_TRUE(budget.acquire(60));
+    EXPECT_TRUE(budget.acquire(1000, [] { return true; }));
+
+    std::atomic<bool> acquired{false};
+    std::thread producer([&] {
+        EXPECT_TRUE(budget.acquire(30));
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired);
+    budget.release(1000);
+    producer.join();
+    EXPECT_TRUE(acquired);
+
+    std::thread aborted([&budget] { EXPECT_FALSE(budget.acquire(30)); });
+    budget.abort();
+    aborted.join();
+}
+
+template <typename Queue>
+class LockFreeQueue : public ::testing::Test {};
+
+using LockFreeQueues = ::testing::Types<MPMCQueue<std::unique_ptr<int>>, SPSCQueue<std::unique_ptr<int>>>;
+TYPED_TEST_SUITE(LockFreeQueue, LockFreeQueues);
+
+TYPED_TEST(LockFreeQueue, FullAndEmpty) {
+    TypeParam queue(4);
+    std::unique_ptr<int> item;
+    EXPECT_FALSE(queue.tryPop(item));
+    for (int i = 0; i < static_cast<int>(queue.capacity()); i++)
+        EXPECT_TRUE(queue.tryPush(std::make_unique<int>(i)));
+
+    auto extra = std::make_unique<int>(-1);
+    EXPECT_FALSE(queue.tryPush(std::move(extra)));
+    ASSERT_TRUE(extra);
+
+    for (int i = 0; i < static_cast<int>(queue.capacity()); i++) {
+        ASSERT_TRUE(queue.tryPop(item));
+        EXPECT_EQ(*item, i);
+    }
+    EXPECT_FALSE(queue.tryPop(item));
+}
+
+TYPED_TEST(LockFreeQueue, ProducerConsumer) {
+    const int n = 100000;
+    TypeParam queue(16);
+    std::thread producer([&queue] {
+        for (int i = 0; i < n; i++)
+            queue.push(std::make_unique<int>(i));
+        queue.close();
+    });
+
+    int expected = 0;
+    std::unique_ptr<int> item;
+    while (queue.pop(item))
+        EXPECT_EQ(*item, expected++);
+    producer.join();
+    EXPECT_EQ(expected, n);
+}
+
+TEST(MPMCQueue, ManyProducersAndConsumers) {
+    const int n = 20000;
+    const int nThreads = 4;
+    MPMCQueue<int> queue(8, nThreads);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < nThreads; p++) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < n; i++)
+                queue.push(p * n + i);
+            queue.close();
+        });
+    }
+
+    std::vector<std::vector<int>> received(nThreads);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < nThreads; c++) {
+        consumers.emplace_back([&queue, &received, c] {
+            int item;
+            while (queue.pop(item))
+                received[c].push_back(item);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto& thread : consumers)
+        thread.join();
+
+    std::vector<int> all;
+    for (const auto& part : received)
+        all.insert(all.end(), part.begin(), part.end());
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), static_cast<size_t>(n * nThreads));
+    for (int i = 0; i < n * nThreads; i++)
+        EXPECT_EQ(all[i], i);
+}
@@ -0,0 +1,604 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#endif
+#endif
+
+#include <AsyncWriter.hh>
+#include <COLA.hh>
+#include <StaticEnsemble.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+namespace {
+    // Generator producing events with a single particle and the event number stored in nColl.
+    class CountingGenerator final : public VGenerator {
+    public:
+        std::unique_ptr<EventData> operator()() override {
+            auto event = std::make_unique<EventData>();
+            event->iniState.nColl = counter++;
+            event->particles.push_back(Particle{{}, {}, 2212, ParticleClass::produced});
+            return event;
+        }
+
+    private:
+        int counter = 0;
+    };
+
+    // Generator storing the index of the event within the run in nColl.
+    class IndexGenerator final : public VGenerator {
+    public:
+        std::unique_ptr<EventData> operator()() override {
+            auto event = newEvent();
+            event->iniState.nColl = static_cast<int>(eventIndex());
+            event->particles.push_back(Particle{{}, {}, 2212, ParticleClass::produced});
+            return event;
+        }
+    };
+
+    // Converter appending a single neutron to the event.
+    class AppendingConverter final : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            data->particles.push_back(Particle{{}, {}, 2112, ParticleClass::produced});
+            return std::move(data);
+        }
+    };
+
+    // Writer storing the number of particles and the number of every received event.
+    class CollectingWriter final : public VWriter {
+    public:
+        static inline std::vector<size_t> sizes;
+        static inline std::vector<int> ids;
+
+        void operator()(std::unique_ptr<EventData>&& data) override {
+            sizes.push_back(data->particles.size());
+            ids.push_back(data->iniState.nColl);
+        }
+    };
+
+    // Converter passing events through, with a derived class appending a neutron.
+    class PassingConverter : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override { return std::move(data); }
+    };
+
+    class DerivedConverter final : public PassingConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            data->particles.push_back(Particle{{}, {}, 2112, ParticleClass::produced});
+            return std::move(data);
+        }
+    };
+
+    // Writer saving whole batches only.
+    class BatchWriter final : public VWriter {
+    public:
+        size_t batches = 0;
+        size_t events = 0;
+
+        void operator()(std::unique_ptr<EventData>&&) override { throw std::logic_error("single event written"); }
+        void writeBatch(EventBatch& batch) override {
+            batches++;
+            events += batch.size();
+        }
+    };
+
+    // Converter appending a neutron to every event of a batch and recording the largest batch.
+    class BatchConverter final : public VConverter {
+    public:
+        static inline std::atomic<size_t> largestBatch{0};
+
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&&) override {
+            throw std::logic_error("single event passed to a batch converter");
+        }
+
+        void processBatch(EventBatch& batch) override {
+            for (auto& event : batch)
+                event->particles.push_back(Particle{{}, {}, 2112, ParticleClass::produced});
+            for (size_t largest = largestBatch; batch.size() > largest and not largestBatch.compare_exchange_weak(largest, batch.size());) {
+            }
+        }
+    };
+
+    // Writer failing on the 50th event.
+    class ThrowingWriter final : public VWriter {
+    public:
+        void operator()(std::unique_ptr<EventData>&&) override {
+            if (++counter == 50)
+                throw std::runtime_error("writer failure");
+        }
+
+    private:
+        int counter = 0;
+    };
+
+    // Converter which is very slow for every 100th event.
+    class UnevenConverter final : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            if (data->iniState.nColl % 100 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return std::move(data);
+        }
+    };
+
+    // Converter which is slow for the first 50 events of the run and counts them per instance, i.e. per worker.
+    class SkewedConverter final : public VConverter {
+    public:
+        static inline std::mutex mutex;
+        static inline std::map<const SkewedConverter*, int> slowEvents;
+
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            if (data->iniState.nColl < 50) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> lock(mutex);
+                ++slowEvents[this];
+            }
+            return std::move(data);
+        }
+    };
+
+    // Converter failing on the 50th event it receives.
+    class ThrowingConverter final : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            if (++counter == 50)
+                throw std::runtime_error("converter failure");
+            return std::move(data);
+        }
+
+    private:
+        int counter = 0;
+    };
+
+    // Converter rejecting the events with an odd number.
+    class RejectingConverter final : public VConverter {
+    public:
+        std::unique_ptr<EventData> operator()(std::unique_ptr<EventData>&& data) override {
+            return data->iniState.nColl % 2 == 0 ? std::move(data) : nullptr;
+        }
+    };
+
+    template <typename Filter>
+    class Factory final : public VFactory {
+    public:
+        static inline std::atomic<int> created{0};
+
+        VFilter* create(const std::map<std::string, std::string>&) override {
+            ++created;
+            return new Filter;
+        }
+    };
+
+    std::string writeConfig(const std::string& name, const std::string& body) {
+        auto fName = ::testing::TempDir() + name;
+        std::ofstream(fName) << "<cola>" << body << "</cola>";
+        return fName;
+    }
+
+    void registerFilters(MetaProcessor& processor) {
+        processor.reg(std::make_unique<Factory<CountingGenerator>>(), "gen", FilterType::generator);
+        processor.reg(std::make_unique<Factory<IndexGenerator>>(), "indexed", FilterType::generator);
+        processor.reg(std::make_unique<Factory<AppendingConverter>>(), "conv", FilterType::converter);
+        processor.reg(std::make_unique<Factory<UnevenConverter>>(), "uneven", FilterType::converter);
+        processor.reg(std::make_unique<Factory<SkewedConverter>>(), "skewed", FilterType::converter);
+        processor.reg(std::make_unique<Factory<ThrowingConverter>>(), "throwing", FilterType::converter);
+        processor.reg(std::make_unique<Factory<BatchConverter>>(), "batch", FilterType::converter);
+        processor.reg(std::make_unique<Factory<RejectingConverter>>(), "rejecting", FilterType::converter);
+        processor.reg(std::make_unique<Factory<CollectingWriter>>(), "writer", FilterType::writer);
+        processor.reg(std::make_unique<Factory<ThrowingWriter>>(), "throwingWriter", FilterType::writer);
+    }
+
+    const std::string chain = R"(<generator name="gen"/><converter name="conv"/><converter name="conv"/><writer name="writer"/>)";
+}
+
+TEST(ColaRunManager, Sequential) {
+    CollectingWriter::sizes.clear();
+    MetaProcessor processor;
+    registerFilters(processor);
+    ColaRunManager manager(processor.parse(writeConfig("sequential.xml", chain)));
+    manager.run(10);
+
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(10, 3));
+}
+
+TEST(ColaRunManager, ParallelWorkers) {
+    CollectingWriter::sizes.clear();
+    Factory<CountingGenerator>::created = 0;
+    Factory<CollectingWriter>::created = 0;
+    MetaProcessor processor;
+    registerFilters(processor);
+    ColaRunManager manager(processor, writeConfig("parallel.xml", chain), RunOptions{4});
+    manager.run(1001);
+
+    EXPECT_EQ(Factory<CountingGenerator>::created, 4);
+    EXPECT_EQ(Factory<CollectingWriter>::created, 1);
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(1001, 3));
+}
+
+TEST(ColaRunManager, Pipelined) {
+    CollectingWriter::sizes.clear();
+    MetaProcessor processor;
+    registerFilters(processor);
+    RunOptions options;
+    options.mode = RunMode::pipelined;
+    options.queueCapacity = 4;
+    ColaRunManager manager(processor.parse(writeConfig("pipelined.xml", chain)), options);
+    manager.run(500);
+
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(500, 3));
+}
+
+TEST(ColaRunManager, UnevenEventCost) {
+    CollectingWriter::sizes.clear();
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("uneven.xml", R"(<generator name="gen"/><converter name="uneven"/><writer name="writer"/>)");
+    ColaRunManager manager(processor, config, RunOptions{3});
+    manager.run(997);
+
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(997, 1));
+}
+
+TEST(ColaRunManager, WorkStealing) {
+    // all the slow events are in the initial range of the first worker, the others have to steal them
+    CollectingWriter::sizes.clear();
+    SkewedConverter::slowEvents.clear();
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("skewed.xml", R"(<generator name="indexed"/><converter name="skewed"/><writer name="writer"/>)");
+    ColaRunManager(processor, config, RunOptions{4}).run(200);
+
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(200, 1));
+    EXPECT_GT(SkewedConverter::slowEvents.size(), 1u);
+    int total = 0;
+    for (const auto& [converter, count] : SkewedConverter::slowEvents) {
+        EXPECT_LT(count, 50);
+        total += count;
+    }
+    EXPECT_EQ(total, 50);
+}
+
+TEST(ColaRunManager, Ordered) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    const auto config = writeConfig("ordered.xml", R"(<generator name="indexed"/><converter name="uneven"/><converter name="conv"/>)"
+                                                   R"(<writer name="writer"/>)");
+    std::vector<int> expected(300);
+    for (int i = 0; i < 300; i++)
+        expected[i] = i;
+    for (auto mode : {RunMode::replicated, RunMode::forked}) {
+        CollectingWriter::sizes.clear();
+        CollectingWriter::ids.clear();
+        RunOptions options{mode == RunMode::forked ? 3u : 4u};
+        options.mode = mode;
+        options.ordered = true;
+        options.reorderWindow = 8;
+        ColaRunManager(processor, config, options).run(300);
+
+        EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(300, 2));
+        EXPECT_EQ(CollectingWriter::ids, expected);
+    }
+}
+
+TEST(ColaRunManager, Forked) {
+    CollectingWriter::sizes.clear();
+    MetaProcessor processor;
+    registerFilters(processor);
+    RunOptions options{3};
+    options.mode = RunMode::forked;
+    options.sharedMemorySize = 256;
+    ColaRunManager manager(processor, writeConfig("forked.xml", chain), options);
+    manager.run(400);
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(400, 3));
+
+    CollectingWriter::sizes.clear();
+    CollectingWriter::ids.clear();
+    options.ordered = true;
+    options.reorderWindow = 4;
+    const auto indexed = R"(<generator name="indexed"/><converter name="conv"/><converter name="conv"/><writer name="writer"/>)";
+    ColaRunManager(processor, writeConfig("forked.xml", indexed), options).run(100);
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(100, 3));
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(CollectingWriter::ids[i], i);
+}
+
+TEST(ColaRunManager, InFlightBudget) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("budget.xml", chain);
+    for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+        for (bool ordered : {false, true}) {
+            CollectingWriter::sizes.clear();
+            RunOptions options{3};
+            options.mode = mode;
+            options.ordered = ordered;
+            options.maxEventsInFlight = 2;
+            options.maxBytesInFlight = 1;
+            ColaRunManager(processor, config, options).run(200);
+            EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(200, 3));
+        }
+    }
+}
+
+TEST(ColaRunManager, ErrorPropagation) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("throwing.xml", R"(<generator name="gen"/><converter name="throwing"/><writer name="writer"/>)");
+    for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+        RunOptions options{2};
+        options.mode = mode;
+        ColaRunManager manager(processor, config, options);
+        try {
+            manager.run(200);
+            ADD_FAILURE() << "run didn't throw";
+        } catch (const std::runtime_error& e) {
+            EXPECT_NE(std::string(e.what()).find("converter failure"), std::string::npos) << e.what();
+        }
+    }
+}
+
+TEST(ColaRunManager, Affinity) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("affinity.xml", chain);
+    for (auto policy : {AffinityPolicy::compact, AffinityPolicy::scatter}) {
+        for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+            CollectingWriter::sizes.clear();
+            RunOptions options{2};
+            options.mode = mode;
+            options.affinity = policy;
+            ColaRunManager(processor, config, options).run(100);
+            EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(100, 3));
+        }
+    }
+
+    RunOptions options{2};
+    options.cpus = {-1, 1 << 20};
+    EXPECT_THROW(ColaRunManager(processor, config, options).run(10), std::runtime_error);
+
+#if defined(MPOL_PREFERRED) && defined(SYS_set_mempolicy) && defined(SYS_get_mempolicy)
+    // the calling thread is a pinned worker, its memory policy must be restored after the run
+    unsigned long nodes = 1;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &nodes, 64) != 0)
+        GTEST_SKIP() << "memory policies are not supported";
+    options.cpus = {0, 0};
+    ColaRunManager(processor, config, options).run(10);
+    int mode = -1;
+    nodes = 0;
+    EXPECT_EQ(syscall(SYS_get_mempolicy, &mode, &nodes, 64, nullptr, 0), 0);
+    EXPECT_EQ(mode, MPOL_PREFERRED);
+    EXPECT_EQ(nodes, 1u);
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+#endif
+}
+
+TEST(ColaRunManager, ConverterReplicas) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("replicas.xml", R"(<generator name="gen"/><converter name="uneven" replicas="4"/>)"
+                                              R"(<converter name="conv"/><writer name="writer"/>)");
+    Factory<UnevenConverter>::created = 0;
+    auto ensemble = processor.parse(config);
+    EXPECT_EQ(Factory<UnevenConverter>::created, 4);
+    ASSERT_EQ(ensemble.converterReplicas.size(), 2u);
+    EXPECT_EQ(ensemble.converterReplicas[0].size(), 3u);
+    EXPECT_EQ(ensemble.converterReplicas[1].size(), 0u);
+
+    // only the pipelined run uses the replicas
+    Factory<UnevenConverter>::created = 0;
+    ColaRunManager(processor, config, RunOptions{}).run(10);
+    EXPECT_EQ(Factory<UnevenConverter>::created, 1);
+
+    for (bool ordered : {false, true}) {
+        CollectingWriter::sizes.clear();
+        CollectingWriter::ids.clear();
+        RunOptions options;
+        options.mode = RunMode::pipelined;
+        options.ordered = ordered;
+        ColaRunManager(processor, config, options).run(500);
+        EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(500, 2));
+        if (ordered) {
+            for (int i = 0; i < 500; i++)
+                EXPECT_EQ(CollectingWriter::ids[i], i);
+        }
+    }
+
+    auto bad = writeConfig("bad_replicas.xml", R"(<generator name="gen"/><converter name="conv" replicas="x"/><writer name="writer"/>)");
+    EXPECT_THROW(processor.parse(bad), std::runtime_error);
+}
+
+TEST(ColaRunManager, AsyncWriter) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("async.xml", R"(<generator name="gen"/><converter name="conv"/>)"
+                                           R"(<writer name="writer" async="true" asyncBuffer="4"/>)");
+    EXPECT_NE(dynamic_cast<AsyncWriter*>(processor.parse(config).writer.get()), nullptr);
+    for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+        CollectingWriter::sizes.clear();
+        CollectingWriter::ids.clear();
+        RunOptions options{2};
+        options.mode = mode;
+        options.ordered = true;
+        ColaRunManager(processor, config, options).run(300);
+        EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(300, 2));
+        if (mode == RunMode::pipelined) {
+            for (int i = 0; i < 300; i++)
+                EXPECT_EQ(CollectingWriter::ids[i], i);
+        }
+    }
+
+    auto throwing = writeConfig("asyncThrowing.xml", R"(<generator name="gen"/><writer name="throwingWriter" async="true"/>)");
+    ColaRunManager manager(processor.parse(throwing));
+    EXPECT_THROW(manager.run(200), std::runtime_error);
+
+    auto malformed = writeConfig("asyncMalformed.xml", R"(<generator name="gen"/><writer name="writer" async="yes"/>)");
+    EXPECT_THROW(processor.parse(malformed), std::runtime_error);
+
+    // the writer thread passes its whole buffer to the wrapped writer
+    auto batchWriter = std::make_unique<BatchWriter>();
+    const auto* batches = batchWriter.get();
+    AsyncWriter async(std::move(batchWriter), 8);
+    for (int i = 0; i < 100; i++)
+        async(std::make_unique<EventData>());
+    async.flush();
+    EXPECT_EQ(batches->events, 100u);
+    EXPECT_GE(batches->batches, 1u);
+}
+
+TEST(ColaRunManager, Batches) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("batch.xml", R"(<generator name="indexed"/><converter name="batch"/><converter name="conv"/>)"
+                                           R"(<writer name="writer"/>)");
+    for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+        for (bool ordered : {false, true}) {
+            CollectingWriter::sizes.clear();
+            CollectingWriter::ids.clear();
+            BatchConverter::largestBatch = 0;
+            RunOptions options{mode == RunMode::pipelined ? 1u : 2u};
+            options.mode = mode;
+            options.ordered = ordered;
+            options.batchSize = 16;
+            options.reorderWindow = 8;
+            options.maxEventsInFlight = ordered ? 6 : 0;
+            ColaRunManager(processor, config, options).run(301);
+            EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(301, 3));
+            if (mode != RunMode::forked) {
+                EXPECT_LE(BatchConverter::largestBatch, ordered ? 8u : 16u);
+                EXPECT_GT(BatchConverter::largestBatch, 1u);
+            }
+            if (ordered) {
+                for (int i = 0; i < 301; i++)
+                    EXPECT_EQ(CollectingWriter::ids[i], i);
+            }
+        }
+    }
+}
+
+TEST(ColaRunManager, RejectedEvents) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    // the batch converter would fail on a rejected event
+    auto config = writeConfig("rejecting.xml", R"(<generator name="gen"/><converter name="rejecting"/><converter name="batch"/>)"
+                                               R"(<writer name="writer"/>)");
+
+    CollectingWriter::ids.clear();
+    ColaRunManager(processor.parse(config)).run(100);
+    EXPECT_EQ(CollectingWriter::ids.size(), 50u);
+
+    for (auto mode : {RunMode::replicated, RunMode::pipelined, RunMode::forked}) {
+        for (bool ordered : {false, true}) {
+            RunOptions options{mode == RunMode::pipelined ? 1u : 2u};
+            options.mode = mode;
+            options.ordered = ordered;
+            options.batchSize = 8;
+            options.reorderWindow = 16;
+            options.maxEventsInFlight = ordered ? 6 : 0;
+
+            CollectingWriter::ids.clear();
+            ColaRunManager(processor, config, options).run(200);
+            for (int id : CollectingWriter::ids)
+                EXPECT_EQ(id % 2, 0);
+            if (mode == RunMode::pipelined) {
+                EXPECT_EQ(CollectingWriter::ids.size(), 100u);
+            }
+
+            CollectingWriter::ids.clear();
+            ColaRunManager(processor, config, options).runUntilAccepted(77);
+            EXPECT_EQ(CollectingWriter::ids.size(), 77u);
+            if (mode == RunMode::pipelined and ordered) {
+                for (int i = 0; i < 77; i++)
+                    EXPECT_EQ(CollectingWriter::ids[i], 2 * i);
+            }
+
+            CollectingWriter::ids.clear();
+            ColaRunManager(processor, config, options).runUntilAccepted(77, 40);
+            EXPECT_LE(CollectingWriter::ids.size(), 40u);
+        }
+    }
+}
+
+TEST(StaticEnsemble, MatchesDynamicChain) {
+    MetaProcessor processor;
+    registerFilters(processor);
+    auto config = writeConfig("static.xml", chain);
+
+    CollectingWriter::sizes.clear();
+    CollectingWriter::ids.clear();
+    ColaRunManager(processor.parse(config)).run(100);
+    const auto dynamicIds = CollectingWriter::ids;
+    const auto dynamicSizes = CollectingWriter::sizes;
+
+    using Chain = StaticEnsemble<CountingGenerator, AppendingConverter, AppendingConverter, CollectingWriter>;
+    CollectingWriter::sizes.clear();
+    CollectingWriter::ids.clear();
+    Chain(processor.parse(config)).run(100);
+    EXPECT_EQ(CollectingWriter::ids, dynamicIds);
+    EXPECT_EQ(CollectingWriter::sizes, dynamicSizes);
+
+    CollectingWriter::sizes.clear();
+    StaticEnsemble<CountingGenerator, CollectingWriter>(std::make_unique<CountingGenerator>(), std::make_unique<CollectingWriter>()).run(10);
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(10, 1));
+
+    // batch methods are called if overridden, and an asynchronous writer is flushed by the end of the run
+    CollectingWriter::sizes.clear();
+    BatchConverter::largestBatch = 0;
+    StaticEnsemble<CountingGenerator, BatchConverter, AppendingConverter, AsyncWriter> batched(
+            std::make_unique<CountingGenerator>(), std::make_unique<BatchConverter>(), std::make_unique<AppendingConverter>(),
+            std::make_unique<AsyncWriter>(std::make_unique<CollectingWriter>(), 4));
+    batched.setBatchSize(16);
+    batched.run(101);
+    EXPECT_EQ(CollectingWriter::sizes, std::vector<size_t>(101, 3));
+    EXPECT_EQ(BatchConverter::largestBatch, 16u);
+
+    auto batchWriter = std::make_unique<BatchWriter>();
+    const auto* batches = batchWriter.get();
+    StaticEnsemble<CountingGenerator, BatchWriter> batchWriting(std::make_unique<CountingGenerator>(), std::move(batchWriter));
+    batchWriting.setBatchSize(8);
+    batchWriting.run(20);
+    EXPECT_EQ(batches->batches, 3u);
+    EXPECT_EQ(batches->events, 20u);
+
+    using Mismatched = StaticEnsemble<CountingGenerator, AppendingConverter, CollectingWriter>;
+    EXPECT_THROW(Mismatched(processor.parse(config)), std::invalid_argument);
+    EXPECT_THROW(Mismatched(processor.parse(writeConfig("mismatched.xml", R"(<generator name="gen"/><converter name="uneven"/><writer name="writer"/>)"))),
+                 std::invalid_argument);
+
+    // the qualified call would skip the override of a derived filter
+    using Passing = StaticEnsemble<CountingGenerator, PassingConverter, CollectingWriter>;
+    processor.reg(std::make_unique<Factory<DerivedConverter>>(), "derived", FilterType::converter);
+    EXPECT_THROW(Passing(processor.parse(writeConfig("derived.xml", R"(<generator name="gen"/><converter name="derived"/><writer name="writer"/>)"))),
+                 std::invalid_argument);
+    EXPECT_THROW(Passing(std::make_unique<CountingGenerator>(), std::make_unique<DerivedConverter>(), std::make_unique<CollectingWriter>()),
+                 std::invalid_argument);
+}
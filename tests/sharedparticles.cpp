@@ -0,0 +1,79 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <memory>
+#include <memory_resource>
+
+#include <COLA.hh>
+#include <EventPool.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+TEST(SharedParticles, CopyOnWrite) {
+    EventParticles nucleons;
+    for (int i = 0; i < 5; i++)
+        nucleons.push_back(Particle{{}, {}, 2212, ParticleClass::spectatorA});
+    const std::shared_ptr<const EventParticles> configuration = std::make_shared<const EventParticles>(std::move(nucleons));
+
+    EventData first{};
+    first.iniState.iniStateParticles = configuration;
+    EventData second = first;
+    EXPECT_TRUE(second.iniState.iniStateParticles.shared());
+    EXPECT_EQ(second.iniState.iniStateParticles.data(), configuration->data());
+    EXPECT_EQ(second.iniState.iniStateParticles.size(), 5u);
+
+    // modification copies the particles once
+    second.iniState.iniStateParticles.push_back(Particle{{}, {}, 2112, ParticleClass::spectatorB});
+    EXPECT_FALSE(second.iniState.iniStateParticles.shared());
+    const auto* copy = second.iniState.iniStateParticles.data();
+    second.iniState.iniStateParticles.modify()[0].pdgCode = 2112;
+    EXPECT_EQ(second.iniState.iniStateParticles.data(), copy);
+    EXPECT_EQ(second.iniState.iniStateParticles.size(), 6u);
+    EXPECT_EQ(configuration->size(), 5u);
+    EXPECT_EQ(first.iniState.iniStateParticles[0].pdgCode, 2212);
+
+    // the pool drops the reference instead of clearing shared particles
+    EventPool pool(1);
+    auto event = std::make_unique<EventData>(first);
+    EXPECT_EQ(configuration.use_count(), 3);
+    pool.release(std::move(event));
+    EXPECT_EQ(configuration.use_count(), 2);
+    EXPECT_TRUE(pool.acquire()->iniState.iniStateParticles.empty());
+
+    // private particles in the inline storage are shared as a heap copy and stay private to the event
+    event = makeSmallEvent<4>();
+    auto& particles = event->iniState.iniStateParticles;
+    auto* storage = particles.get_allocator().resource();
+    particles.push_back(Particle{{}, {}, 2212, ParticleClass::spectatorA});
+    const auto sharedCopy = particles.share();
+    EXPECT_EQ(particles.share(), sharedCopy);
+    EXPECT_EQ(sharedCopy->get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_NE(sharedCopy->data(), particles.data());
+    particles.modify()[0].pdgCode = 2112;
+    EXPECT_EQ((*sharedCopy)[0].pdgCode, 2212);
+    EXPECT_EQ(particles.get_allocator().resource(), storage);
+
+    // assigning shared particles keeps the inline storage for the next modification
+    particles = configuration;
+    EXPECT_EQ(particles.data(), configuration->data());
+    particles.push_back(Particle{{}, {}, 2112, ParticleClass::spectatorB});
+    EXPECT_EQ(particles.get_allocator().resource(), storage);
+    EXPECT_EQ(particles.size(), 6u);
+}
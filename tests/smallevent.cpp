@@ -0,0 +1,76 @@
+/**
+* Copyright (c) 2024-2025 Alexandr Svetlichnyi, Savva Savenkov, Artemii Novikov
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include <memory_resource>
+
+#include <COLA.hh>
+#include <EventPool.hh>
+#include <gtest/gtest.h>
+
+using namespace cola;
+
+TEST(SmallEvent, SpillsOnlyLargeEvents) {
+    // counts the allocations passed to the heap
+    class CountingResource final : public std::pmr::memory_resource {
+    public:
+        int allocations = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    } heap;
+
+    // the storage passes larger requests to the default resource at its construction
+    auto* previous = std::pmr::set_default_resource(&heap);
+    auto event = makeSmallEvent<4>();
+    std::pmr::set_default_resource(previous);
+    EXPECT_EQ(heap.allocations, 0);
+    for (int i = 0; i < 4; i++) {
+        event->particles.push_back(Particle{{}, {}, 2212, ParticleClass::produced});
+        event->iniState.iniStateParticles.push_back(Particle{{}, {}, 2112, ParticleClass::spectatorA});
+    }
+    EXPECT_EQ(heap.allocations, 0);
+
+    event->particles.push_back(Particle{{}, {}, 2212, ParticleClass::produced});
+    EXPECT_EQ(heap.allocations, 1);
+    EXPECT_EQ(event->particles.size(), 5u);
+    EXPECT_EQ(event->particles[3].pdgCode, 2212);
+
+    // the released slot serves the other vector
+    event->iniState.iniStateParticles.clear();
+    event->iniState.iniStateParticles.shrink_to_fit();
+    event->iniState.iniStateParticles.reserve(4);
+    EXPECT_EQ(heap.allocations, 1);
+
+    // recycled events keep the inline storage
+    EventPool pool(1, makeSmallEvent<4>);
+    event = pool.acquire();
+    auto* storage = event->particles.get_allocator().resource();
+    EXPECT_GE(event->particles.capacity(), 4u);
+    pool.release(std::move(event));
+    event = pool.acquire();
+    EXPECT_EQ(event->particles.get_allocator().resource(), storage);
+    EXPECT_GE(event->particles.capacity(), 4u);
+}